@@ -1,6 +1,8 @@
 #ifndef CONTROLLER_H_
 #define CONTROLLER_H_
 
+#include <vector>
+
 #include "IEntity.h"
 #include "util/json.h"
 
@@ -25,6 +27,15 @@ class IController {
    **/
   virtual void addEntity(const IEntity& entity) = 0;
 
+  /**
+   * @brief Add a batch of entities to the program. Controllers that can
+   * send them in one message override this; by default each is added alone.
+   * @param entities The entities, in the order they were created
+   **/
+  virtual void addEntities(const std::vector<IEntity*>& entities) {
+    for (const IEntity* entity : entities) addEntity(*entity);
+  }
+
   /**
    * @brief To update the entity information and add it to the program
    * @param entity Type IEntity contain entity object
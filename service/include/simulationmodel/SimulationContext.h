@@ -0,0 +1,144 @@
+#ifndef SIMULATION_CONTEXT_H_
+#define SIMULATION_CONTEXT_H_
+
+#include <atomic>
+
+#include "ATC.h"
+#include "DataCollectionManager.h"
+#include "EntityRegistry.h"
+#include "EntityStore.h"
+#include "StrategyPool.h"
+
+/**
+ * @class SimulationContext
+ * @brief Everything one simulation shares between its entities: the entity
+ * store, the ATC, the metrics, the pool of movement strategies and the random
+ * seed.
+ *
+ * Each SimulationModel owns a context, so several simulations can run in one
+ * process, each on its own thread, without seeing each other's entities or
+ * metrics. Entities keep a pointer to the context they were created in.
+ * While the model creates entities it binds its context to the calling
+ * thread, which is how an entity constructor finds it.
+ */
+class SimulationContext {
+ public:
+  /**
+   * @brief Binds a context to the calling thread for the lifetime of the
+   * scope, and restores the previous one afterwards
+   */
+  class Scope {
+   public:
+    /**
+     * @brief Constructor
+     * @param context Context to bind
+     */
+    explicit Scope(SimulationContext& context);
+
+    /**
+     * @brief Destructor, binds the previous context again
+     */
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    SimulationContext* previous;
+  };
+
+  /**
+   * @brief Constructor
+   * @param seed Seed of the simulation's random numbers; each entity
+   * derives its own generator from it and its id
+   */
+  explicit SimulationContext(unsigned seed = 1);
+
+  SimulationContext(const SimulationContext&) = delete;
+  SimulationContext& operator=(const SimulationContext&) = delete;
+
+  /**
+   * @brief Get the context bound to the calling thread
+   * @return The bound context
+   * @throws std::logic_error if no context is bound
+   */
+  static SimulationContext& current();
+
+  /**
+   * @brief Hand out the next entity id; ids are dense within a simulation
+   * and never reused. Safe to call from several threads at once.
+   * @return An id no other entity of this simulation has
+   */
+  int nextId();
+
+  /**
+   * @brief Get the id the next entity will get
+   * @return The next id nextId() hands out
+   */
+  int peekNextId() const;
+
+  /**
+   * @brief Make nextId() continue from an id, so entities restored from a
+   * snapshot get the ids they were saved with
+   * @param id The next id to hand out
+   */
+  void setNextId(int id);
+
+  /**
+   * @brief Get the entity store
+   * @return The store holding the entities' kinematic state
+   */
+  EntityStore& getStore();
+
+  /**
+   * @brief Get the live entities
+   * @return The registry the model adds its entities to
+   */
+  EntityRegistry& getEntities();
+
+  /**
+   * @brief Get the pool of movement strategies
+   * @return The pool the entities make their strategies in
+   */
+  StrategyPool& getStrategies();
+
+  /**
+   * @brief Get the ATC
+   * @return The air traffic control of this simulation
+   */
+  ATC& getATC();
+
+  /**
+   * @brief Get the data collection manager
+   * @return The metrics of this simulation
+   */
+  DataCollectionManager& getDataCollection();
+
+  /**
+   * @brief Get the seed of the simulation's random numbers
+   * @return The seed the context was created with
+   */
+  unsigned getSeed() const;
+
+  /**
+   * @brief Take over the seed of a restored snapshot; only entities created
+   * afterwards seed their generators from it
+   * @param seed Seed of the simulation's random numbers
+   */
+  void setSeed(unsigned seed);
+
+ private:
+  std::atomic<int> ids{0};
+  // outlives everything that holds a strategy
+  StrategyPool strategies;
+  // the store goes last, since the others still refer to entities in it
+  EntityStore store;
+  EntityRegistry entities;
+  DataCollectionManager dataCollection;
+  ATC atc;
+  unsigned seed;
+
+  static thread_local SimulationContext* bound;
+};
+
+#endif  // SIMULATION_CONTEXT_H_
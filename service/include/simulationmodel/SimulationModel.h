@@ -2,8 +2,14 @@
 #define SIMULATION_MODEL_H_
 
 #include <deque>
+#include <limits>
+#include <functional>
+#include <istream>
 #include <map>
+#include <ostream>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
 #include "CompositeFactory.h"
 #include "Drone.h"
@@ -12,6 +18,10 @@
 #include "IEntity.h"
 #include "IObserver.h"
 #include "Robot.h"
+#include "SimulationContext.h"
+#include "SpatialTiles.h"
+#include "ThreadPool.h"
+#include "TimerWheel.h"
 
 //--------------------  Model ----------------------------
 
@@ -25,8 +35,10 @@ class SimulationModel : public IObserver {
  public:
   /**
    * @brief Default constructor that create the SimulationModel object
+   * @param controller Controller the model reports to
+   * @param seed Seed of the simulation's random numbers
    **/
-  SimulationModel(IController &controller);
+  SimulationModel(IController &controller, unsigned seed = 1);
 
   /**
    * @brief Destructor
@@ -46,6 +58,14 @@ class SimulationModel : public IObserver {
    **/
   IEntity *createEntity(const JsonObject &entity);
 
+  /**
+   * @brief Creates a batch of entities, such as a whole scene, and tells the
+   * controller about all of them at once
+   * @param details Details of each entity, as for createEntity
+   * @return The entities created; details no factory accepts are skipped
+   */
+  std::vector<IEntity *> createEntities(const JsonArray &details);
+
   /**
    * @brief Removes entity with given ID from the simulation
    *
@@ -80,6 +100,13 @@ class SimulationModel : public IObserver {
    */
   const routing::Graph *getGraph() const;
 
+  /**
+   * @brief Returns the context holding this simulation's entity store, ATC,
+   * metrics and random numbers
+   * @returns The model's context
+   */
+  SimulationContext &getContext();
+
   /**
    * @brief Notifies observers with message string
    * @param &message Type string contain message to notify observers
@@ -106,15 +133,189 @@ class SimulationModel : public IObserver {
    */
   JsonObject getDeliveryQueueInfo() const;
 
-  std::deque<Package *> scheduledDeliveries;
+  /**
+   * @brief Stops updating an entity until it is woken
+   * @param id Id of the entity
+   * @param until Simulation time to wake the entity at, if nothing wakes it
+   * earlier
+   */
+  void sleepEntity(int id,
+                   double until = std::numeric_limits<double>::infinity());
+
+  /**
+   * @brief Updates a sleeping entity again from the next tick on
+   * @param id Id of the entity
+   */
+  void wakeEntity(int id);
+
+  /**
+   * @brief Checks if an entity is sleeping
+   * @param id Id of the entity
+   * @return True if the entity's updates are skipped
+   */
+  bool isAsleep(int id) const;
+
+  /**
+   * @brief Puts an idle entity to sleep until a delivery is queued
+   * @param id Id of the entity
+   * @param until Simulation time to wake the entity at, if no delivery is
+   * queued earlier
+   */
+  void awaitDelivery(int id,
+                     double until = std::numeric_limits<double>::infinity());
+
+  /**
+   * @brief Wakes the entities waiting for a delivery, call after adding to
+   * the scheduled deliveries
+   */
+  void wakeAwaitingDelivery();
+
+  /**
+   * @brief Tells the model a package reached its robot. When deliveries are
+   * retired, both leave the simulation at the end of the tick.
+   * @param package The delivered package
+   */
+  void packageDelivered(Package *package);
+
+  /**
+   * @brief Gets the simulation time
+   * @return Seconds simulated so far
+   */
+  double getTime() const;
+
+  /**
+   * @brief Gets the number of ticks simulated so far
+   * @return Calls to update since the model was created
+   */
+  long getTicks() const;
+
+  /**
+   * @brief Sets the tiles the awake entities are split into for the
+   * parallel update. Each tile is updated by one thread; the outcome of a
+   * tick does not depend on the tiling.
+   * @param size Edge of a tile in meters; zero turns tiling off and splits
+   * the entities into even chunks instead
+   */
+  void setTileSize(double size);
+
+  /**
+   * @brief Gets the tiles the awake entities are split into
+   * @return The tiles of the last update
+   */
+  const SpatialTiles &getTiles() const;
+
+  /**
+   * @brief Sets whether delivered packages and the robots that received
+   * them are removed from the simulation, so a steady stream of trips keeps
+   * the number of entities bounded. The metrics of retired entities are not
+   * exported.
+   * @param retire True to retire deliveries
+   */
+  void setRetireDelivered(bool retire);
+
+  /**
+   * @brief Checks whether delivered packages are retired
+   * @return True if deliveries leave the simulation
+   */
+  bool getRetireDelivered() const;
+
+  /**
+   * @brief Brings sleeping entities up to date and logs the ticks they
+   * skipped so far, so their metrics are complete before the logs are
+   * exported
+   */
+  void logSleepingTime();
+
+  /**
+   * @brief Gets an entity of the simulation
+   * @param id Id of the entity
+   * @return The entity with its decorators, nullptr if there is none
+   */
+  IEntity *getEntity(int id) const;
+
+  /**
+   * @brief Gets a drone without the decorators the factory wrapped it in
+   * @param id Id of the drone
+   * @return The undecorated drone, nullptr if the id is not a drone
+   */
+  Drone *getDrone(int id) const;
+
+  /**
+   * @brief Writes the state of the simulation to a binary snapshot: every
+   * entity with its decorators and paths, the delivery queue, the sleeping
+   * entities, the ATC and the metrics. The graph is not part of it. Call
+   * between ticks; the ATC commands the next tick would start with are
+   * applied first.
+   * @param out Stream to write to
+   * @throws std::runtime_error if the stream fails
+   */
+  void save(std::ostream &out);
+
+  /**
+   * @brief Restores a snapshot written by save() into a model that has no
+   * entities yet, after which the simulation continues where the saved one
+   * stopped. Set the graph first; it is not part of the snapshot. A run with
+   * a synchronous ATC continues exactly like the saved one would have.
+   * @param in Stream to read from
+   * @throws std::runtime_error if the snapshot cannot be read
+   * @throws std::logic_error if the model already has entities
+   */
+  void restore(std::istream &in);
+
+  /**
+   * @brief Takes the first delivery off the queue, skipping packages that
+   * were removed from the simulation
+   * @return The package to deliver, nullptr if the queue is empty
+   */
+  Package *takeDelivery();
+
+  // packages waiting for a drone, highest priority first; packages removed
+  // from the simulation stay behind as null references until they come up
+  std::deque<EntityRef<Package>> scheduledDeliveries;
 
  protected:
+  // declared first, so it outlives everything that refers to it
+  SimulationContext context;
   IController &controller;
-  std::map<int, IEntity *> entities;
+  // the live entities, kept in the context so entities can check references
+  EntityRegistry &entities;
   std::set<int> removed;
+  // whether delivered packages and their robots are removed
+  bool retireDelivered = false;
   void removeFromSim(int id);
+  // creates and registers an entity without telling the controller
+  IEntity *spawn(const JsonObject &entity, bool verbose);
+  // drops the queued deliveries whose packages were removed
+  void dropRemovedDeliveries();
+  // sorts the awake entities into tiles and groups their store rows by tile
+  void assignTiles();
   const routing::Graph *graph = nullptr;
   CompositeFactory entityFactory;
+
+  // when a sleeping entity fell asleep and the alarm that wakes it
+  struct Sleeper {
+    long tick;
+    double time;
+    double until = std::numeric_limits<double>::infinity();
+    TimerWheel::Handle alarm = 0;
+  };
+
+  // entities that get updated, in id order, and the ones that sleep
+  std::map<int, IEntity *> awake;
+  std::unordered_map<int, Sleeper> sleeping;
+  std::set<int> awaitingDelivery;
+  TimerWheel timers;
+  long ticks = 0;
+  double time = 0;
+
+  // entities in update order and the effects each one committed this tick
+  std::vector<IEntity *> updateOrder;
+  std::vector<std::vector<std::function<void()>>> effects;
+  ThreadPool workers;
+  // tiles of the awake entities and their ids in update order
+  SpatialTiles tiles;
+  std::vector<int> updateIds;
+  std::vector<int> tiledIds;
 };
 
 #endif
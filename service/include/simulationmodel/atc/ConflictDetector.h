@@ -0,0 +1,270 @@
+#ifndef CONFLICT_DETECTOR_H_
+#define CONFLICT_DETECTOR_H_
+
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "FlightSnapshot.h"
+#include "SweptCapsuleTree.h"
+#include "VelocityObstacleSolver.h"
+
+class SnapshotReader;
+class SnapshotWriter;
+
+/**
+ * @class ConflictDetector
+ * @brief Conflict detection and resolution behind the ATC.
+ *
+ * Works only on flight snapshots and answers with commands, so it can run on
+ * a thread of its own. A swept-capsule tree over the airspace of every entity
+ * finds the pairs that could conflict at all; those pairs are kept in a
+ * schedule keyed by the earliest time they could come into conflict,
+ * conflicts are tracked as episodes, and conflicted entities are rerouted
+ * along velocities from one batched velocity-obstacle solve.
+ */
+class ConflictDetector {
+ public:
+  /**
+   * @brief Constructor
+   */
+  ConflictDetector();
+
+  /**
+   * @brief Bring the registry in line with a snapshot and evaluate every pair
+   * that is due
+   * @param snapshot Latest state of the flying entities
+   * @param commands Receives the reroute and log commands, in order
+   */
+  void process(const FlightSnapshot& snapshot,
+               std::vector<ATCCommand>& commands);
+
+  /**
+   * @brief How far ahead conflicts are looked for. Faster entities look
+   * further ahead, so they get more time to react.
+   * @param speed Speed of the entity
+   * @return Look-ahead horizon in seconds
+   */
+  static double lookAheadTime(double speed);
+
+  /**
+   * @brief Airspace an entity could claim: the segment it flies within its
+   * look-ahead horizon, inflated by half the separation minimum. Entities
+   * whose capsules do not intersect cannot be in conflict.
+   * @param state Current state of the entity
+   * @return Capsule of the entity
+   */
+  static SweptCapsuleTree::Capsule airspace(const FlightState& state);
+
+  /**
+   * @brief How far the tree fattens the box of an entity, so that it is
+   * reinserted only every few seconds of flight
+   * @param state Current state of the entity
+   * @return Margin for SweptCapsuleTree::update
+   */
+  static double airspaceMargin(const FlightState& state);
+
+  /**
+   * @brief Write the registry, the conflict schedule, the open conflict
+   * episodes and the airspace tree to a snapshot
+   * @param out Snapshot to write to
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * @brief Replace the detector's state with the one written by save()
+   * @param in Snapshot to read from
+   */
+  void load(SnapshotReader& in);
+
+  // seconds of flight covered by the fattening of an airspace box
+  static constexpr double marginTime = 2.0;
+
+ private:
+  /**
+   * @brief A pair of registrations waiting in the conflict schedule
+   */
+  struct ScheduledPair {
+    double time;
+    int a;
+    int b;
+    // route epochs of a and b when the pair was scheduled
+    unsigned long epochA;
+    unsigned long epochB;
+
+    /**
+     * @brief Orders pairs by time, then by handles for a stable schedule
+     */
+    bool operator>(const ScheduledPair& other) const;
+  };
+
+  /**
+   * @brief A pair of registrations that is currently in conflict
+   */
+  struct ConflictEpisode {
+    // sim time the conflict was first detected
+    double start;
+    // last sim time willCollide reported the pair
+    double lastSeen;
+    double minSeparation;
+    bool unavoidable = false;
+  };
+
+  /**
+   * @brief Register new handles, drop missing ones and give changed routes a
+   * new epoch
+   */
+  void reconcile();
+
+  /**
+   * @brief Evaluate every pair whose scheduled time has come up and
+   * reschedule it
+   */
+  void evaluate();
+
+  /**
+   * @brief Evaluate one pair, opening, extending or closing its conflict
+   * episode. A potential collision is logged once per episode.
+   * @param i Slot of the first entity
+   * @param j Slot of the second entity
+   * @return True if the pair is in conflict and at least one of the two
+   * entities can still change course
+   */
+  bool evaluatePair(size_t i, size_t j);
+
+  /**
+   * @brief Log the duration and minimum separation of a conflict episode
+   * for both entities and forget it
+   * @param episode Iterator into activeConflicts
+   * @return Iterator following the removed episode
+   */
+  std::map<std::pair<int, int>, ConflictEpisode>::iterator closeConflict(
+      std::map<std::pair<int, int>, ConflictEpisode>::iterator episode);
+
+  /**
+   * @brief Reroute conflicted entities along collision-free velocities
+   * computed in one batched velocity-obstacle solve
+   * @param conflicted Slots of the entities found in conflict this update
+   * @param holdTimes Seconds each slot must hold its new course at least,
+   * i.e. until the closest approach of its conflicts
+   */
+  void resolveConflicts(const std::vector<size_t>& conflicted,
+                        const std::vector<double>& holdTimes);
+
+  /**
+   * @brief Give a registration a new route epoch and schedule all of its
+   * pairs for the current snapshot
+   * @param slot Slot of the registration
+   */
+  void scheduleAllPairs(size_t slot);
+
+  /**
+   * @brief Schedule the pairs a registration newly overlaps in the airspace
+   * tree, after its box was reinserted
+   * @param slot Slot of the registration
+   */
+  void discoverPairs(size_t slot);
+
+  /**
+   * @brief Push a pair onto the schedule
+   */
+  void schedule(double time, size_t i, size_t j);
+
+  /**
+   * @brief Check whether a pair has a current entry in the schedule
+   */
+  bool isTracked(int a, int b) const;
+
+  /**
+   * @brief Drop schedule entries that refer to removed registrations or old
+   * route epochs
+   */
+  void compactSchedule();
+
+  /**
+   * @brief Check whether an entity is mid-reroute, counting reroutes that
+   * were sent but not yet applied
+   */
+  bool isRerouted(size_t slot) const;
+
+  /**
+   * @brief Append a command to the output of the current process call
+   * @return The new command, for filling in further fields
+   */
+  ATCCommand& emit(ATCCommand::Type type, int handle, const char* name,
+                   double value);
+
+  /**
+   * @brief Check if two entities will come closer than the separation
+   * minimum within the shorter of their look-ahead horizons
+   */
+  bool willCollide(const FlightState& a, const FlightState& b) const;
+
+  /**
+   * @brief Lower bound on the time until willCollide could first report a
+   * conflict between two entities
+   * @return Seconds until a conflict is possible, 0 if it is possible now
+   */
+  double timeUntilPossibleConflict(const FlightState& a,
+                                   const FlightState& b) const;
+
+  /**
+   * @brief Time until two entities are closest on their current courses
+   * @return Seconds until the closest approach, 0 if it is already past
+   */
+  double timeToClosestApproach(const FlightState& a,
+                               const FlightState& b) const;
+
+  static constexpr float altitudeThreshold = 50.0f;
+  static constexpr float baseCollisionTime = 5.0f;
+  // extra seconds of look-ahead per unit of speed
+  static constexpr double lookAheadPerSpeed = 0.3;
+  static constexpr float collisionDistanceThreshold = 50.0f;
+  // a conflict must stay clear this many seconds before its episode ends
+  static constexpr double conflictExitTime = 1.0;
+
+  // snapshot and output of the current process call
+  const FlightSnapshot* snapshot = nullptr;
+  std::vector<ATCCommand>* commands = nullptr;
+  // maps a handle to its index in the current snapshot
+  std::unordered_map<int, size_t> slots;
+
+  /**
+   * @brief Hash of a handle pair
+   */
+  struct PairHash {
+    size_t operator()(const std::pair<int, int>& pair) const {
+      return std::hash<unsigned long long>()(
+          static_cast<unsigned long long>(static_cast<unsigned>(pair.first))
+              << 32 |
+          static_cast<unsigned>(pair.second));
+    }
+  };
+
+  // route epoch of every registered handle
+  std::unordered_map<int, unsigned long> epochs;
+  // reroutes sent to the simulation, by handle, with their sequence number
+  std::unordered_map<int, unsigned long> pendingReroutes;
+  unsigned long nextSequence = 0;
+
+  // airspace capsules of every registration, refit every snapshot
+  SweptCapsuleTree airspaceTree;
+  // route epochs of the current schedule entry of each (smaller, larger)
+  // handle pair; pairs whose airspace does not overlap have none
+  std::unordered_map<std::pair<int, int>,
+                     std::pair<unsigned long, unsigned long>, PairHash>
+      trackedPairs;
+
+  // min-heap of pairs keyed by their earliest possible conflict time
+  std::vector<ScheduledPair> schedulePairs;
+  unsigned long nextEpoch = 0;
+
+  // open conflict episodes keyed by the (smaller, larger) handle pair
+  std::map<std::pair<int, int>, ConflictEpisode> activeConflicts;
+
+  VelocityObstacleSolver solver;
+};
+
+#endif  // CONFLICT_DETECTOR_H_
@@ -0,0 +1,58 @@
+#ifndef FLIGHT_SNAPSHOT_H_
+#define FLIGHT_SNAPSHOT_H_
+
+#include <vector>
+
+#include "math/vector3.h"
+
+/**
+ * @brief Kinematic state of one flying entity at the end of a tick
+ */
+struct FlightState {
+  int handle;
+  Vector3 position;
+  Vector3 direction;
+  double speed;
+  bool rerouted;
+};
+
+/**
+ * @brief Everything the ATC needs from one simulation tick. The simulation
+ * thread fills it in and hands it to the ATC, which never touches entities.
+ */
+struct FlightSnapshot {
+  // simulation time at the end of the tick
+  double time = 0;
+  // sequence number of the last ATC command applied by the simulation
+  unsigned long appliedCommands = 0;
+  std::vector<FlightState> entities;
+  // handles whose route changed discontinuously since the last snapshot
+  std::vector<int> routeChanges;
+};
+
+/**
+ * @brief An action the ATC asks the simulation thread to carry out
+ */
+struct ATCCommand {
+  enum class Type {
+    // reroute handle along velocity for value seconds
+    Reroute,
+    // add value to the metric name of handle
+    Log,
+    // lower the metric name of handle to value
+    LogMinimum,
+    // add value to the ATC system metric name
+    LogSystem
+  };
+
+  Type type = Type::Log;
+  int handle = -1;
+  Vector3 velocity;
+  double value = 0;
+  // metric name, always a string literal
+  const char* name = nullptr;
+  // increases by one for every command the ATC emits
+  unsigned long sequence = 0;
+};
+
+#endif  // FLIGHT_SNAPSHOT_H_
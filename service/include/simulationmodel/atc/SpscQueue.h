@@ -0,0 +1,66 @@
+#ifndef SPSC_QUEUE_H_
+#define SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class SpscQueue
+ * @brief Bounded lock-free queue for exactly one producer thread and one
+ * consumer thread.
+ *
+ * The capacity is rounded up to a power of two. push fails instead of
+ * blocking when the queue is full, pop fails when it is empty.
+ */
+template <typename T>
+class SpscQueue {
+ public:
+  /**
+   * @brief Constructor
+   * @param capacity Minimum number of elements the queue can hold
+   */
+  explicit SpscQueue(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    buffer.resize(size);
+    mask = size - 1;
+  }
+
+  /**
+   * @brief Append an element, called by the producer only
+   * @param value Element to copy into the queue
+   * @return False if the queue is full
+   */
+  bool push(const T& value) {
+    size_t back = tail.load(std::memory_order_relaxed);
+    if (back - head.load(std::memory_order_acquire) == buffer.size()) {
+      return false;
+    }
+    buffer[back & mask] = value;
+    tail.store(back + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Remove the oldest element, called by the consumer only
+   * @param value Receives the element
+   * @return False if the queue is empty
+   */
+  bool pop(T& value) {
+    size_t front = head.load(std::memory_order_relaxed);
+    if (front == tail.load(std::memory_order_acquire)) return false;
+    value = buffer[front & mask];
+    head.store(front + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  std::vector<T> buffer;
+  size_t mask = 0;
+  // producer and consumer indices live on separate cache lines
+  alignas(64) std::atomic<size_t> head{0};
+  alignas(64) std::atomic<size_t> tail{0};
+};
+
+#endif  // SPSC_QUEUE_H_
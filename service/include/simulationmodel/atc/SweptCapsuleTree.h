@@ -0,0 +1,144 @@
+#ifndef SWEPT_CAPSULE_TREE_H_
+#define SWEPT_CAPSULE_TREE_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "math/vector3.h"
+
+class SnapshotReader;
+class SnapshotWriter;
+
+/**
+ * @class SweptCapsuleTree
+ * @brief Bounding volume hierarchy over the airspace flying entities sweep
+ * out in the next few seconds.
+ *
+ * Every entity is a capsule: the segment it travels along, inflated by a
+ * radius. Leaves store a box fattened by a margin, so updating a capsule that
+ * still fits its fat box costs nothing; only capsules that leave it are
+ * reinserted. Internal nodes are refit on the way back up, the tree is never
+ * rebuilt.
+ */
+class SweptCapsuleTree {
+ public:
+  /**
+   * @brief Segment swept by an entity, inflated by a radius
+   */
+  struct Capsule {
+    Vector3 start;
+    Vector3 end;
+    double radius = 0;
+  };
+
+  /**
+   * @brief Insert a capsule or move an existing one
+   * @param handle Identifies the entity
+   * @param capsule New capsule of the entity
+   * @param margin How far the leaf box is fattened when it is (re)inserted
+   * @return True if the leaf was inserted or reinserted, i.e. its fat box
+   * changed and it may overlap leaves it did not overlap before
+   */
+  bool update(int handle, const Capsule& capsule, double margin);
+
+  /**
+   * @brief Remove a capsule. Unknown handles are ignored.
+   * @param handle Identifies the entity
+   */
+  void remove(int handle);
+
+  /**
+   * @brief Check whether a handle has a capsule in the tree
+   */
+  bool contains(int handle) const;
+
+  /**
+   * @brief Get the number of capsules in the tree
+   */
+  size_t size() const;
+
+  /**
+   * @brief Find every capsule that intersects a capsule
+   * @param capsule Capsule to test against
+   * @param handles Receives the handles of the intersecting capsules
+   */
+  void query(const Capsule& capsule, std::vector<int>& handles) const;
+
+  /**
+   * @brief Find every leaf whose fat box overlaps the fat box of a leaf.
+   * Pairs of leaves can only start to overlap when one of them is
+   * reinserted, so this is all a broad phase needs after an update.
+   * @param handle Leaf to test against
+   * @param handles Receives the overlapping handles, excluding handle
+   */
+  void queryOverlaps(int handle, std::vector<int>& handles) const;
+
+  /**
+   * @brief Check whether the fat boxes of two leaves overlap
+   * @return False if either handle is unknown
+   */
+  bool overlaps(int a, int b) const;
+
+  /**
+   * @brief Write the tree node for node, so a restored tree answers queries
+   * in the same order
+   * @param out Snapshot to write to
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * @brief Replace the tree with the one written by save()
+   * @param in Snapshot to read from
+   */
+  void load(SnapshotReader& in);
+
+ private:
+  /**
+   * @brief Axis-aligned bounding box
+   */
+  struct Box {
+    Vector3 min;
+    Vector3 max;
+
+    bool overlaps(const Box& other) const;
+    bool contains(const Box& other) const;
+    Box merge(const Box& other) const;
+    double area() const;
+  };
+
+  struct Node {
+    Box box;
+    int parent = -1;
+    int left = -1;
+    int right = -1;
+    // handle and exact capsule of a leaf, -1 for internal nodes
+    int handle = -1;
+    Capsule capsule;
+
+    bool isLeaf() const { return left < 0; }
+  };
+
+  /**
+   * @brief Tight box around a capsule
+   */
+  static Box bounds(const Capsule& capsule);
+
+  /**
+   * @brief Check whether two capsules intersect
+   */
+  static bool intersects(const Capsule& a, const Capsule& b);
+
+  int allocateNode();
+  void freeNode(int node);
+  void insertLeaf(int leaf);
+  void removeLeaf(int leaf);
+  void refitAncestors(int node);
+
+  std::vector<Node> nodes;
+  std::vector<int> freeNodes;
+  int root = -1;
+  // maps a handle to its leaf node
+  std::unordered_map<int, int> leaves;
+};
+
+#endif  // SWEPT_CAPSULE_TREE_H_
@@ -0,0 +1,58 @@
+#ifndef VELOCITY_OBSTACLE_SOLVER_H_
+#define VELOCITY_OBSTACLE_SOLVER_H_
+
+#include <vector>
+
+#include "math/vector3.h"
+
+/**
+ * @class VelocityObstacleSolver
+ * @brief Computes collision-free velocities for a batch of flying entities
+ * using optimal reciprocal collision avoidance (ORCA).
+ *
+ * Avoidance happens in the horizontal (x, z) plane; the vertical component of
+ * each velocity is kept as is. Every neighbour within range and within the
+ * altitude band contributes one half-plane constraint, and a small linear
+ * program picks the velocity closest to the current one that satisfies all of
+ * them.
+ */
+class VelocityObstacleSolver {
+ public:
+  /**
+   * @brief Kinematic state of one entity taking part in the solve
+   */
+  struct Agent {
+    Vector3 position;
+    Vector3 velocity;
+    double radius = 0;
+    double maxSpeed = 0;
+    // seconds ahead the velocity must stay collision free
+    double horizon = 0;
+    // neighbours further away than this are ignored
+    double range = 0;
+    // false for entities that will not change course (e.g. mid-reroute)
+    bool responsive = true;
+    // true for entities that can turn but not slow down
+    bool fixedSpeed = false;
+  };
+
+  /**
+   * @brief Constructor
+   * @param altitudeBand Entities further apart vertically are ignored
+   */
+  VelocityObstacleSolver(double altitudeBand);
+
+  /**
+   * @brief Solve for new velocities of the conflicted agents in one pass
+   * @param agents All agents that may act as obstacles
+   * @param conflicted Indices into agents that need a new velocity
+   * @return New velocity for each entry of conflicted, in the same order
+   */
+  std::vector<Vector3> solve(const std::vector<Agent>& agents,
+                             const std::vector<size_t>& conflicted) const;
+
+ private:
+  double altitudeBand;
+};
+
+#endif  // VELOCITY_OBSTACLE_SOLVER_H_
@@ -47,6 +47,17 @@ class IDataLogger {
   virtual void logEvent(IEntity* entity, std::string eventName,
                         double metric) = 0;
 
+  /**
+   * @brief Records a metric that keeps its smallest value for an entity
+   * @param entity Pointer to the entity generating the event
+   * @param eventName Name of the metric being recorded
+   * @param metric Value to compare against the current minimum
+   *
+   * Creates the metric entry on first use, otherwise lowers it if needed.
+   */
+  virtual void logMinimum(IEntity* entity, std::string eventName,
+                          double metric) = 0;
+
   /**
    * @brief Removes an entity from the logging system
    * @param entity Pointer to the entity to remove
@@ -55,11 +66,25 @@ class IDataLogger {
    */
   virtual void removeEntity(IEntity* entity) = 0;
 
+  /**
+   * @brief Records a metric event for a simulation subsystem
+   * @param component Name of the subsystem generating the event
+   * @param eventName Name of the metric being recorded
+   * @param metric Value of the metric to add
+   *
+   * Used for counters that do not belong to a single entity, such as the
+   * number of ATC evaluations.
+   */
+  virtual void logSystemEvent(const std::string& component,
+                              const std::string& eventName, double metric) = 0;
+
  protected:
   std::map<int, std::map<std::string, double>>
       logMap;  ///< Maps entity IDs to their metrics
   std::map<int, std::string>
       idToName;  ///< Maps entity IDs to names for readable logs
+  std::map<std::string, std::map<std::string, double>>
+      systemLog;  ///< Maps subsystem names to their metrics
 };
 
 #endif  // IDATALOGGER_H_
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "IEntity.h"
 #include "IStrategy.h"
+#include "StrategyPool.h"
 #include "math/vector3.h"
 
 // Represents an Airplane in a physical system.
@@ -33,10 +34,31 @@ class Airplane : public IEntity {
    */
   void update(double dt);
 
+  /**
+   * @brief Writes the airplane's state to a snapshot
+   * @param out The snapshot to write to
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * @brief Reads the state written by save()
+   * @param in The snapshot to read from
+   */
+  void load(SnapshotReader& in);
+
   bool arrived = false;
 
+ protected:
+  /**
+   * @brief Constructor for decorators, which forward everything to the
+   * decorated airplane and need no details of their own
+   * @param tag Selects this constructor
+   * @param wrapped The decorated airplane
+   */
+  Airplane(DecoratorTag tag, const IEntity& wrapped);
+
  private:
-  IStrategy* toDestination = nullptr;
+  StrategyHandle toDestination;
 
   // dcm distance logging
   double distanceTraveled = 0;
@@ -3,8 +3,10 @@
 
 #include <vector>
 
+#include "EntityRef.h"
 #include "IEntity.h"
 #include "IStrategy.h"
+#include "StrategyPool.h"
 #include "math/vector3.h"
 
 class Package;
@@ -44,6 +46,25 @@ class Drone : public IEntity {
    */
   void update(double dt);
 
+  /**
+   * @brief Catches up on the distance log after sleeping
+   * @param seconds Simulation time the drone slept through
+   * @param ticks Number of ticks the drone slept through
+   */
+  void fastForward(double seconds, long ticks);
+
+  /**
+   * @brief Writes the drone's state to a snapshot
+   * @param out The snapshot to write to
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * @brief Reads the state written by save()
+   * @param in The snapshot to read from
+   */
+  void load(SnapshotReader& in);
+
   /**
    * @brief Removing the copy constructor operator
    * so that drones cannot be copied.
@@ -65,10 +86,40 @@ class Drone : public IEntity {
    */
   void setPackage(Package* p);
 
+ protected:
+  /**
+   * @brief Constructor for decorators, which forward everything to the
+   * decorated drone and need no details of their own
+   * @param tag Selects this constructor
+   * @param wrapped The decorated drone
+   */
+  Drone(DecoratorTag tag, const IEntity& wrapped);
+
+  /**
+   * @brief Carry a package for the current tick; the simulation moves it
+   * along with the drone once every entity is updated
+   * @param package The package being carried, nullptr to carry nothing
+   */
+  void carry(Package* package);
+
+  /**
+   * @brief Writes the state subclasses share with Drone: the entity state
+   * and the assigned package. LeaderDrone and HelperDrone keep the rest of
+   * their delivery state in members of their own.
+   * @param out The snapshot to write to
+   */
+  void saveShared(SnapshotWriter& out) const;
+
+  /**
+   * @brief Reads the state written by saveShared()
+   * @param in The snapshot to read from
+   */
+  void loadShared(SnapshotReader& in);
+
  private:
-  Package* package = nullptr;
-  IStrategy* toPackage = nullptr;
-  IStrategy* toFinalDestination = nullptr;
+  EntityRef<Package> package;
+  StrategyHandle toPackage;
+  StrategyHandle toFinalDestination;
 
   double distanceTraveled = 0;
   Vector3 lastPosition;
@@ -0,0 +1,51 @@
+#ifndef ENTITY_REF_H_
+#define ENTITY_REF_H_
+
+#include "EntityRegistry.h"
+#include "IEntity.h"
+
+/**
+ * @class EntityRef
+ * @brief Reference from one entity to another that turns null once the
+ * other entity is removed from the simulation, instead of dangling.
+ *
+ * The reference keeps the pointer next to the registry handle of the
+ * entity, and only hands out the pointer while the handle is live. It
+ * converts to and from a plain pointer, so it reads like one.
+ *
+ * @tparam T Type of the referenced entity; may be a decorated entity, which
+ * lives exactly as long as its outermost decorator
+ */
+template <typename T>
+class EntityRef {
+ public:
+  EntityRef() = default;
+
+  /**
+   * @brief Refer to an entity that was added to the simulation
+   * @param entity The entity, may be nullptr
+   */
+  EntityRef(T* entity) : entity(entity) {
+    if (!entity) return;
+    registry = &entity->registry();
+    handle = registry->handle(entity->getId());
+  }
+
+  /**
+   * @brief Get the entity
+   * @return The entity, nullptr if there is none or it was removed
+   */
+  T* get() const {
+    return registry && registry->contains(handle) ? entity : nullptr;
+  }
+
+  T* operator->() const { return get(); }
+  operator T*() const { return get(); }
+
+ private:
+  T* entity = nullptr;
+  const EntityRegistry* registry = nullptr;
+  EntityRegistry::Handle handle;
+};
+
+#endif  // ENTITY_REF_H_
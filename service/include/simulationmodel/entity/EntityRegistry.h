@@ -0,0 +1,123 @@
+#ifndef ENTITY_REGISTRY_H_
+#define ENTITY_REGISTRY_H_
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IdMap.h"
+#include "SlotMap.h"
+
+class IEntity;
+
+/**
+ * @class EntityRegistry
+ * @brief The live entities of a simulation, each under a handle that goes
+ * stale once the entity is removed.
+ *
+ * Entities are kept in a slot map, so iterating them walks one dense array,
+ * and adding or removing one takes constant time. Ids are never handed out
+ * twice within a simulation; lookups by id go through an IdMap of the live
+ * ids, which does not grow with the ids a long run has retired. Entities
+ * are also indexed by name and by the type they were created as, so finding
+ * one by name does not scan the simulation.
+ *
+ * The registry holds the outermost decorator of each entity under the id of
+ * the entity it decorates. It is only changed on the simulation thread,
+ * outside of the parallel entity update.
+ */
+class EntityRegistry {
+ public:
+  using Handle = SlotMap<IEntity*>::Handle;
+
+  EntityRegistry() = default;
+  EntityRegistry(const EntityRegistry&) = delete;
+  EntityRegistry& operator=(const EntityRegistry&) = delete;
+
+  /**
+   * @brief Add an entity under its id. Adding an id twice is ignored.
+   * @param entity The entity
+   * @return Handle of the entity
+   */
+  Handle add(IEntity* entity);
+
+  /**
+   * @brief Remove an entity; its handles go stale. Unknown ids are ignored.
+   * @param id Id of the entity
+   * @return True if an entity was removed
+   */
+  bool remove(int id);
+
+  /**
+   * @brief Look up an entity by id
+   * @param id Id of the entity
+   * @return The entity, nullptr if there is none
+   */
+  IEntity* get(int id) const;
+
+  /**
+   * @brief Look up an entity by handle
+   * @param handle Handle of the entity
+   * @return The entity, nullptr if it was removed
+   */
+  IEntity* get(Handle handle) const;
+
+  /**
+   * @brief Find the entities with a name
+   * @param name Name of the entities
+   * @return Their ids in ascending order, empty if there are none
+   */
+  const std::set<int>& named(const std::string& name) const;
+
+  /**
+   * @brief Find the entities created with a type, such as "robot" or
+   * "leader_drone"
+   * @param type Type from the entity's details
+   * @return Their ids in ascending order, empty if there are none
+   */
+  const std::set<int>& ofType(const std::string& type) const;
+
+  /**
+   * @brief Get the handle of an entity
+   * @param id Id of the entity
+   * @return The handle, a handle that names nothing if there is no entity
+   */
+  Handle handle(int id) const;
+
+  /**
+   * @brief Check whether a handle still names an entity
+   * @param handle The handle
+   * @return True if the entity is live
+   */
+  bool contains(Handle handle) const;
+
+  /**
+   * @brief Get the number of live entities
+   * @return Entities in the registry
+   */
+  size_t size() const;
+
+  /**
+   * @brief Check whether there are live entities
+   * @return True without entities
+   */
+  bool empty() const;
+
+  /**
+   * @brief Iterate the live entities, in the order they were added until
+   * one is removed
+   */
+  std::vector<IEntity*>::const_iterator begin() const;
+  std::vector<IEntity*>::const_iterator end() const;
+
+ private:
+  SlotMap<IEntity*> entities;
+  // handle of each live id
+  IdMap<Handle> handles;
+  // ids by name and by type
+  std::unordered_map<std::string, std::set<int>> names;
+  std::unordered_map<std::string, std::set<int>> types;
+};
+
+#endif  // ENTITY_REGISTRY_H_
@@ -0,0 +1,129 @@
+#ifndef ENTITY_STORE_H_
+#define ENTITY_STORE_H_
+
+#include <vector>
+
+#include "IdMap.h"
+#include "math/vector3.h"
+
+/**
+ * @class EntityStore
+ * @brief Holds the state of every entity of a simulation in dense, parallel
+ * arrays.
+ *
+ * Entities are ids; the components of an entity live in the same row of each
+ * column. Rows are kept contiguous by moving the last row into the hole left
+ * by a removal. Ids map to rows through an IdMap of the live ids, so a
+ * lookup is about two array reads and the index stays the size of the store
+ * however many ids a long run hands out. Code that works on all entities at
+ * once (movement, the ATC snapshot, serialization) can stream over the
+ * columns directly.
+ *
+ * Rows are only added and removed on the simulation thread, outside of the
+ * parallel entity update; during the update each entity writes its own row.
+ */
+class EntityStore {
+ public:
+  /**
+   * @brief Progress of a package through its delivery
+   */
+  enum class DeliveryState : unsigned char {
+    Unscheduled,
+    Scheduled,
+    PickedUp,
+    Delivered
+  };
+
+  EntityStore() = default;
+  EntityStore(const EntityStore&) = delete;
+  EntityStore& operator=(const EntityStore&) = delete;
+
+  /**
+   * @brief Add a row with default components. Adding an id twice is ignored.
+   * @param id Id of the entity
+   */
+  void add(int id);
+
+  /**
+   * @brief Remove the row of an entity. Unknown ids are ignored.
+   * @param id Id of the entity
+   */
+  void remove(int id);
+
+  /**
+   * @brief Check whether an entity has a row
+   * @param id Id of the entity
+   * @return True if the entity has a row
+   */
+  bool contains(int id) const;
+
+  /**
+   * @brief Get the number of rows
+   * @return Number of entities in the store
+   */
+  size_t size() const;
+
+  /**
+   * @brief Get the row of an entity
+   * @param id Id of an entity in the store
+   * @return Index of the entity's row in every column
+   */
+  size_t row(int id) const { return *rows.get(id); }
+
+  /**
+   * @brief Components of a single entity
+   */
+  Vector3& position(int id) { return positions[row(id)]; }
+  Vector3& direction(int id) { return directions[row(id)]; }
+  double& speed(int id) { return speeds[row(id)]; }
+  double& battery(int id) { return batteries[row(id)]; }
+  int& carrying(int id) { return carried[row(id)]; }
+  DeliveryState& delivery(int id) { return deliveries[row(id)]; }
+
+  /**
+   * @brief Reorder the rows: the rows of the given ids come first, in that
+   * order, and the other rows follow in their current order. Ids keep their
+   * components; only the rows change.
+   * @param order Ids to put first, each at most once
+   */
+  void arrange(const std::vector<int>& order);
+
+  /**
+   * @brief Move every carried package to its carrier
+   */
+  void followCarriers();
+
+  /**
+   * @brief Work out where every path follower ends up after one step along
+   * its straight stretch, in one pass over the columns. Path strategies take
+   * the result instead of stepping the entity themselves.
+   * @param dt Length of the step in seconds
+   */
+  void walkPaths(double dt);
+
+  // id of the entity in each row
+  std::vector<int> ids;
+  std::vector<Vector3> positions;
+  std::vector<Vector3> directions;
+  std::vector<double> speeds;
+  // charge of battery-powered entities
+  std::vector<double> batteries;
+  // id of the package an entity carries, -1 if none
+  std::vector<int> carried;
+  std::vector<DeliveryState> deliveries;
+  // the straight stretch each path follower walks next, set by the strategy
+  // that moved it last: the strategy's token (0 if none), the unit direction
+  // (zero if none), and the length left before the stretch turns
+  std::vector<unsigned long> walkers;
+  std::vector<Vector3> walkDirections;
+  std::vector<double> walkLengths;
+  // where walkPaths() put each row after a step of walkedDt seconds
+  std::vector<Vector3> walkSteps;
+  double walkedDt = 0;
+
+ private:
+  // row of each id in the store
+  IdMap<size_t> rows;
+};
+
+#endif  // ENTITY_STORE_H_
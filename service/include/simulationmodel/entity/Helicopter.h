@@ -3,6 +3,7 @@
 
 #include "IEntity.h"
 #include "IStrategy.h"
+#include "StrategyPool.h"
 /**
  * @class Helicopter
  * @brief Represents an helicopter in the simulation model
@@ -26,8 +27,29 @@ class Helicopter : public IEntity {
    */
   void update(double dt);
 
+  /**
+   * @brief Writes the helicopter's state to a snapshot
+   * @param out The snapshot to write to
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * @brief Reads the state written by save()
+   * @param in The snapshot to read from
+   */
+  void load(SnapshotReader& in);
+
+ protected:
+  /**
+   * @brief Constructor for decorators, which forward everything to the
+   * decorated helicopter and need no details of their own
+   * @param tag Selects this constructor
+   * @param wrapped The decorated helicopter
+   */
+  Helicopter(DecoratorTag tag, const IEntity& wrapped);
+
  private:
-  IStrategy* movement = nullptr;
+  StrategyHandle movement;
   double distanceTraveled = 0;
   unsigned int mileCounter = 0;
   Vector3 lastPosition;
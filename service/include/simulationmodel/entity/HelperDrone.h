@@ -6,6 +6,8 @@
 #include "Drone.h"
 #include "IEntity.h"
 #include "IStrategy.h"
+#include "Pooled.h"
+#include "StrategyPool.h"
 #include "math/vector3.h"
 
 class Package;
@@ -16,7 +18,9 @@ class Package;
  * euler integration based on a specified velocity and direction. These drones
  * assist leader drones through the observer pattern, as observers.
  */
-class HelperDrone : public Drone, public IObserver {
+class HelperDrone : public Drone,
+                    public IObserver,
+                    public Pooled<HelperDrone> {
  public:
   /**
    * @brief Drones are created with a name
@@ -46,6 +50,25 @@ class HelperDrone : public Drone, public IObserver {
    */
   void update(double dt);
 
+  /**
+   * @brief Catches up on the distance log after sleeping
+   * @param seconds Simulation time the drone slept through
+   * @param ticks Number of ticks the drone slept through
+   */
+  void fastForward(double seconds, long ticks);
+
+  /**
+   * @brief Writes the drone's state to a snapshot
+   * @param out The snapshot to write to
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * @brief Reads the state written by save()
+   * @param in The snapshot to read from
+   */
+  void load(SnapshotReader& in);
+
   /**
    * @brief Removing the copy constructor operator
    * so that drones cannot be copied.
@@ -76,8 +99,8 @@ class HelperDrone : public Drone, public IObserver {
   bool pickedUp = false;
 
  private:
-  IStrategy* toPackage = nullptr;
-  IStrategy* toFinalDestination = nullptr;
+  StrategyHandle toPackage;
+  StrategyHandle toFinalDestination;
   std::string drone_type = "HelperDrone";
 
   // dcm distance logging
@@ -3,6 +3,7 @@
 
 #include "IEntity.h"
 #include "IStrategy.h"
+#include "StrategyPool.h"
 
 /**
  * @class Human
@@ -27,9 +28,21 @@ class Human : public IEntity {
    */
   void update(double dt);
 
+  /**
+   * @brief Writes the human's state to a snapshot
+   * @param out The snapshot to write to
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * @brief Reads the state written by save()
+   * @param in The snapshot to read from
+   */
+  void load(SnapshotReader& in);
+
  private:
   static Vector3 kellerPosition;
-  IStrategy* movement = nullptr;
+  StrategyHandle movement;
   bool atKeller = false;
 
   double distanceTraveled = 0;
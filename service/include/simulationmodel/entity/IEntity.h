@@ -1,14 +1,21 @@
 #ifndef ENTITY_H_
 #define ENTITY_H_
 
+#include <functional>
+#include <random>
 #include <vector>
 
+#include "EntityRegistry.h"
+#include "EntityStore.h"
 #include "Graph.h"
 #include "IPublisher.h"
 #include "math/vector3.h"
 #include "util/json.h"
 
+class SimulationContext;
 class SimulationModel;
+class SnapshotReader;
+class SnapshotWriter;
 
 /**
  * @class IEntity
@@ -22,7 +29,8 @@ class SimulationModel;
 class IEntity : public IPublisher {
  public:
   /**
-   * @brief Constructor that assigns a unique ID to the entity.
+   * @brief Constructor that assigns a unique ID to the entity. The entity
+   * belongs to the simulation context bound to the calling thread.
    */
   IEntity();
 
@@ -50,6 +58,12 @@ class IEntity : public IPublisher {
    */
   virtual int getId() const;
 
+  /**
+   * @brief Gets the simulation the entity belongs to.
+   * @return The context the entity was created in.
+   */
+  SimulationContext& getContext() const;
+
   /**
    * @brief Gets the position of the entity.
    * @return The position of the entity.
@@ -112,14 +126,75 @@ class IEntity : public IPublisher {
 
   /**
    * @brief Updates the entity's position in the physical system.
+   *
+   * Entities are updated in parallel. An update may change the entity's own
+   * state and read anything else, but effects on other entities or on the
+   * model have to go through commit().
    * @param dt The time step of the update.
    */
   virtual void update(double dt) = 0;
 
+  /**
+   * @brief Notifies the observers of the entity once the current update is
+   * committed.
+   * @param message The message to send.
+   */
+  void notifyObservers(const std::string& message) override;
+
+  /**
+   * @brief Runs an effect on other entities or on the model. During the
+   * parallel update the effect is deferred to the serial commit phase, where
+   * effects run in entity order; outside of it the effect runs right away.
+   * @param effect The effect to run.
+   */
+  static void commit(std::function<void()> effect);
+
+  /**
+   * @brief Defers the effects committed on the calling thread.
+   * @param effects Receives the effects, or nullptr to run them right away.
+   */
+  static void deferEffects(std::vector<std::function<void()>>* effects);
+
+  /**
+   * @brief Stops updating the entity once the current update is committed.
+   * A sleeping entity costs nothing per tick until it is woken.
+   */
+  virtual void sleep();
+
+  /**
+   * @brief Stops updating the entity until a simulation time, or until it is
+   * woken earlier.
+   * @param time Simulation time in seconds to wake up at.
+   */
+  virtual void sleepUntil(double time);
+
+  /**
+   * @brief Updates the entity again from the next tick on.
+   */
+  virtual void wake();
+
+  /**
+   * @brief Checks if the entity is sleeping. Sleep only changes in the commit
+   * phase, so this is safe to read during the parallel update.
+   * @return True if the model skips the entity's updates.
+   */
+  virtual bool isAsleep() const;
+
+  /**
+   * @brief Brings the entity up to date after it slept, in one jump instead
+   * of one update per tick. By default nothing changes while asleep.
+   * @param seconds Simulation time the entity slept through.
+   * @param ticks Number of ticks the entity slept through.
+   */
+  virtual void fastForward(double /*seconds*/, long /*ticks*/) {}
+
   /**
    * @brief Reroutes the entity to avoid collision.
+   * @param velocity Collision-free velocity chosen by the ATC; the entity
+   * detours along its direction.
+   * @param duration Seconds the detour should last to clear the conflict
    */
-  virtual void reroute() {}
+  virtual void reroute(const Vector3& /*velocity*/, double /*duration*/) {}
 
   /**
    * @brief Checks if the entity has been rerouted.
@@ -127,15 +202,70 @@ class IEntity : public IPublisher {
    */
   virtual bool isRerouted() { return false; }
 
+  /**
+   * @brief Writes the entity's state to a snapshot. Subclasses write their
+   * own state after their base class's.
+   * @param out The snapshot to write to.
+   */
+  virtual void save(SnapshotWriter& out) const;
+
+  /**
+   * @brief Reads the state written by save(). Runs once every entity of the
+   * snapshot exists again, so references to other entities are resolved by
+   * id through the linked model.
+   * @param in The snapshot to read from.
+   */
+  virtual void load(SnapshotReader& in);
+
+  /**
+   * @brief Gets the live entities of the entity's simulation.
+   * @return The registry the entity is looked up in.
+   */
+  const EntityRegistry& registry() const;
+
  protected:
+  /**
+   * @brief Selects the constructor of decorators.
+   */
+  struct DecoratorTag {};
+
+  /**
+   * @brief Constructor for decorators. A decorator stands in for the entity
+   * it wraps, so it shares that entity's id and store row instead of
+   * taking an id, a row and a random seed of its own.
+   * @param wrapped The decorated entity.
+   */
+  IEntity(DecoratorTag, const IEntity& wrapped);
+
+  /**
+   * @brief Gets the store of the entity's simulation.
+   * @return The store holding the entity's kinematic state.
+   */
+  EntityStore& store() const;
+
+  /**
+   * @brief Draws from the entity's own random numbers. The generator is
+   * seeded from the simulation seed and the entity id, so the draws do not
+   * depend on the order entities are updated in.
+   * @param low Smallest value.
+   * @param high Largest value.
+   * @return A uniformly distributed number between low and high.
+   */
+  double uniform(double low, double high);
+
+  SimulationContext* context;
   SimulationModel* model = nullptr;
   int id = -1;
   JsonObject details;
-  Vector3 position;
-  Vector3 direction;
   std::string color;
   std::string name;
-  double speed = 0;
+  std::minstd_rand random;
+
+ private:
+  // false for decorators, whose row belongs to the entity they wrap
+  bool ownsRow = true;
+  // effects committed by the entity being updated on this thread
+  static thread_local std::vector<std::function<void()>>* deferredEffects;
 };
 
 #endif
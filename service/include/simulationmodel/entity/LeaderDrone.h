@@ -1,12 +1,16 @@
 #ifndef LEADERDRONE_H_
 #define LEADERDRONE_H_
+#include <map>
 #include <string>
 #include <vector>
 
 #include "Drone.h"
+#include "EntityRef.h"
 #include "HelperDrone.h"
 #include "IEntity.h"
 #include "IStrategy.h"
+#include "Pooled.h"
+#include "StrategyPool.h"
 #include "math/vector3.h"
 
 class Package;
@@ -19,7 +23,7 @@ class Package;
  * @brief Represents a drone in a physical system. Drones move using euler
  * integration based on a specified velocity and direction.
  */
-class LeaderDrone : public Drone {
+class LeaderDrone : public Drone, public Pooled<LeaderDrone> {
  public:
   /**
    * @brief Drones are created with a name
@@ -48,6 +52,25 @@ class LeaderDrone : public Drone {
    * @param dt Delta time
    */
   void update(double dt);
+
+  /**
+   * @brief Catches up on the battery drain and distance log after sleeping
+   * @param seconds Simulation time the drone slept through
+   * @param ticks Number of ticks the drone slept through
+   */
+  void fastForward(double seconds, long ticks);
+
+  /**
+   * @brief Writes the drone's state to a snapshot
+   * @param out The snapshot to write to
+   */
+  void save(SnapshotWriter &out) const;
+
+  /**
+   * @brief Reads the state written by save()
+   * @param in The snapshot to read from
+   */
+  void load(SnapshotReader &in);
   /**
    * @brief Depletes the drone's battery
    * @param dt double change in time, to delete the battery in proportion of
@@ -100,14 +123,26 @@ class LeaderDrone : public Drone {
   bool pickedUp = false;
 
  private:
-  IStrategy *toPackage = nullptr;
-  IStrategy *toFinalDestination = nullptr;
-  IStrategy *toChargingStation = nullptr;
-  double battery_health = 100.0;
+  /**
+   * @brief Charge of the battery, kept in the entity store
+   */
+  double &battery();
+
+  StrategyHandle toPackage;
+  StrategyHandle toFinalDestination;
+  StrategyHandle toChargingStation;
   double max_battery_health = 100.0;
   double critical_battery_health = 25.0;
   double emergency_battery_health = 13.0;
-  std::map<HelperDrone *, double> handoffResponses;
+  // battery drained per second, also while idle
+  double battery_drain = .01;
+  // answers to handoff requests by helper id; a helper removed since it
+  // answered reads as nullptr and is skipped
+  struct HandoffResponse {
+    EntityRef<HelperDrone> helper;
+    double distance;
+  };
+  std::map<int, HandoffResponse> handoffResponses;
 
   Vector3 charging_station_location = Vector3(92, 254, -124);
   std::string drone_type = "LeaderDrone";
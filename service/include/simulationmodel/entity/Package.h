@@ -3,9 +3,11 @@
 
 #include <vector>
 
+#include "EntityRef.h"
 #include "ExpeditedShipping.h"
 #include "IEntity.h"
 #include "NoRushShipping.h"
+#include "Pooled.h"
 #include "PriorityShipping.h"
 #include "StandardShipping.h"
 #include "math/vector3.h"
@@ -17,7 +19,7 @@ class Robot;
  * @brief Represents a package in a physical system. Packages are delivered by
  * drones to robots
  */
-class Package : public IEntity {
+class Package : public IEntity, public Pooled<Package> {
  public:
   /**
    * @brief Constructor
@@ -25,6 +27,11 @@ class Package : public IEntity {
    */
   Package(const JsonObject &obj);
 
+  /**
+   * @brief Destructor, frees the shipping priority
+   */
+  ~Package();
+
   /**
    * @brief Gets the Package's destination
    * @return The Package's destination
@@ -114,14 +121,14 @@ class Package : public IEntity {
    *
    * @return true if the package is scheduled, false otherwise.
    */
-  bool isScheduled() const { return scheduled; }
+  bool isScheduled() const;
 
   /**
    * @brief Sets the scheduled status of the package.
    *
    * @param val Boolean indicating whether the package is scheduled.
    */
-  void setScheduled(bool val) { scheduled = val; }
+  void setScheduled(bool val);
 
   /**
    * @brief Marks the package as picked up.
@@ -147,15 +154,31 @@ class Package : public IEntity {
    */
   bool getDeliveredPackage() const;
 
+  /**
+   * @brief Writes the package's state to a snapshot
+   * @param out The snapshot to write to
+   */
+  virtual void save(SnapshotWriter &out) const;
+
+  /**
+   * @brief Reads the state written by save()
+   * @param in The snapshot to read from
+   */
+  virtual void load(SnapshotReader &in);
+
  protected:
   bool requiresDelivery_ = true;
   Vector3 destination;
+  Vector3 lastPosition;
   std::string strategyName;
-  Robot *owner = nullptr;
+  EntityRef<Robot> owner;
   PriorityShipping *priority = nullptr;
-  bool pickedUp = false;
-  bool isDelivered = false;
-  bool scheduled = false;
+
+ private:
+  /**
+   * @brief Progress of the delivery, kept in the entity store
+   */
+  EntityStore::DeliveryState &delivery() const;
 };
 
 #endif  // PACKAGE_H
@@ -3,7 +3,9 @@
 
 #include <vector>
 
+#include "EntityRef.h"
 #include "IEntity.h"
+#include "Pooled.h"
 #include "math/vector3.h"
 #include "util/json.h"
 
@@ -16,7 +18,7 @@ class Package;
  * Robots move using euler integration based on a specified
  * velocity and direction.
  */
-class Robot : public IEntity {
+class Robot : public IEntity, public Pooled<Robot> {
  public:
   /**
    * @brief Constructor
@@ -38,10 +40,22 @@ class Robot : public IEntity {
    */
   void receive(Package* p);
 
+  /**
+   * @brief Writes the robot's state to a snapshot
+   * @param out The snapshot to write to
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * @brief Reads the state written by save()
+   * @param in The snapshot to read from
+   */
+  void load(SnapshotReader& in);
+
   bool requestedDelivery = true;
 
  protected:
-  Package* package = nullptr;
+  EntityRef<Package> package;
 };
 
 #endif  // ROBOT_H
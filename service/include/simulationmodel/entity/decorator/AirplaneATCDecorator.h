@@ -17,8 +17,10 @@ class AirplaneATCDecorator : public AirplaneDecorator {
 
   /**
    * @brief Reroute the airplane to avoid collision
+   * @param velocity Collision-free velocity chosen by the ATC
+   * @param duration Seconds the detour should last
    */
-  void reroute();
+  void reroute(const Vector3& velocity, double duration) override;
 
   /**
    * @brief Update the airplane's position and direction
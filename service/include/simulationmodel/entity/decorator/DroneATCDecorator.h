@@ -3,12 +3,14 @@
 
 #include "Drone.h"
 #include "DroneDecorator.h"
+#include "Pooled.h"
 
 /**
  * @brief DroneATCDecorator is a decorator that reroutes the drone to avoid
  * collision
  */
-class DroneATCDecorator : public DroneDecorator {
+class DroneATCDecorator : public DroneDecorator,
+                          public Pooled<DroneATCDecorator> {
  public:
   /**
    * @brief Constructor for DroneATCDecorator
@@ -18,8 +20,10 @@ class DroneATCDecorator : public DroneDecorator {
 
   /**
    * @brief Reroute the drone to avoid collision
+   * @param velocity Collision-free velocity chosen by the ATC
+   * @param duration Seconds the detour should last
    */
-  void reroute() override;
+  void reroute(const Vector3& velocity, double duration) override;
 
   /**
    * @brief Update the drone's position and direction
@@ -6,11 +6,13 @@
 #include "HelperDrone.h"
 #include "LeaderDrone.h"
 #include "Package.h"
+#include "Pooled.h"
 
 /**
  * @brief DroneColorDecorator is a decorator that decorates a Drone with a color
  */
-class DroneColorDecorator : public DroneDecorator {
+class DroneColorDecorator : public DroneDecorator,
+                            public Pooled<DroneColorDecorator> {
  private:
   double hue = 0;
   double saturation = 0;
@@ -37,6 +39,16 @@ class DroneColorDecorator : public DroneDecorator {
    * @brief Update the color of the Drone
    */
   void update(double dt);
+  /**
+   * @brief Write the state of the Drone and its color to a snapshot
+   * @param out The snapshot to write to
+   */
+  void save(SnapshotWriter& out) const;
+  /**
+   * @brief Read the state written by save()
+   * @param in The snapshot to read from
+   */
+  void load(SnapshotReader& in);
   /**
    * @brief Get the decorated entity
    * @return The decorated entity
@@ -1,10 +1,13 @@
 #ifndef FLYING_ENTITY_DECORATOR_H_
 #define FLYING_ENTITY_DECORATOR_H_
 
+#include <algorithm>
+
 #include "BeelineStrategy.h"
 #include "IEntity.h"
 #include "IEntityDecorator.h"
 #include "IStrategy.h"
+#include "Snapshot.h"
 
 /**
  * @brief FlyingEntityDecorator is a decorator that decorates a FlyingEntity
@@ -16,17 +19,7 @@ class FlyingEntityDecorator : public IEntityDecorator<T> {
    * @brief Constructor for FlyingEntityDecorator
    * @param entity The entity to decorate
    */
-  FlyingEntityDecorator(T* entity)
-      : IEntityDecorator<T>(entity), reroutedDestination(nullptr) {}
-
-  /**
-   * @brief Destructor for FlyingEntityDecorator
-   */
-  virtual ~FlyingEntityDecorator() {
-    if (reroutedDestination) {
-      delete reroutedDestination;
-    }
-  }
+  FlyingEntityDecorator(T* entity) : IEntityDecorator<T>(entity) {}
 
   /**
    * @brief Check if the entity is rerouted
@@ -36,16 +29,67 @@ class FlyingEntityDecorator : public IEntityDecorator<T> {
 
   /**
    * @brief Reroute the entity
+   * @param velocity Collision-free velocity to detour along
+   * @param duration Seconds the detour should last
    */
-  virtual void reroute() {}
+  virtual void reroute(const Vector3& /*velocity*/, double /*duration*/) {}
 
   /**
    * @brief Update the entity
    */
-  virtual void update(double dt) {}
+  virtual void update(double /*dt*/) {}
+  /**
+   * @brief Bring the entity up to date after it slept
+   * @param seconds Simulation time the entity slept through
+   * @param ticks Number of ticks the entity slept through
+   */
+  virtual void fastForward(double seconds, long ticks) {
+    timeSinceReroute += seconds;
+    this->sub->fastForward(seconds, ticks);
+  }
+  /**
+   * @brief Write the state of the entity and its detour to a snapshot
+   * @param out The snapshot to write to
+   */
+  virtual void save(SnapshotWriter& out) const {
+    IEntityDecorator<T>::save(out);
+    PathStrategy::save(out, reroutedDestination);
+    out.write(rerouted);
+    out.write(timeSinceReroute);
+  }
+  /**
+   * @brief Read the state written by save()
+   * @param in The snapshot to read from
+   */
+  virtual void load(SnapshotReader& in) {
+    IEntityDecorator<T>::load(in);
+    reroutedDestination = PathStrategy::load(in, this->sub);
+    rerouted = in.read<bool>();
+    timeSinceReroute = in.read<double>();
+  }
 
  protected:
-  IStrategy* reroutedDestination;
+  /**
+   * @brief Start a beeline detour from the current position
+   * @param velocity Direction of the detour
+   * @param duration Seconds the detour should last
+   * @param minDistance Shortest detour to fly
+   */
+  void detour(const Vector3& velocity, double duration, double minDistance) {
+    Vector3 position = this->sub->getPosition();
+    double distance =
+        std::max(minDistance, this->sub->getSpeed() * duration);
+    Vector3 newTarget = position + velocity.unit() * distance;
+
+    reroutedDestination.reset();
+    reroutedDestination =
+        BeelineStrategy::create(this->sub, position, newTarget);
+    rerouted = true;
+    // a sleeping entity still has to fly the detour
+    this->sub->wake();
+  }
+
+  StrategyHandle reroutedDestination;
   bool rerouted = false;
   double timeSinceReroute = 500;
 };
@@ -12,10 +12,12 @@ template <std::derived_from<IEntity> T = IEntity>
 class IEntityDecorator : public T {
  public:
   /**
-   * @brief Constructor for IEntityDecorator
+   * @brief Constructor for IEntityDecorator. The decorator forwards its state
+   * and details to the decorated entity, so it shares the entity's id and
+   * store row and copies nothing.
    * @param e The entity to decorate
    */
-  IEntityDecorator(T* e) : T(e->getDetails()), sub(e) {}
+  IEntityDecorator(T* e) : T(typename T::DecoratorTag(), *e), sub(e) {}
   /**
    * @brief Destructor for IEntityDecorator
    */
@@ -89,6 +91,32 @@ class IEntityDecorator : public T {
    * @param dt The time step
    */
   virtual void update(double dt) { return sub->update(dt); }
+  /**
+   * @brief Stop updating the entity until it is woken
+   */
+  virtual void sleep() { return sub->sleep(); }
+  /**
+   * @brief Stop updating the entity until a simulation time
+   * @param time The simulation time to wake up at
+   */
+  virtual void sleepUntil(double time) { return sub->sleepUntil(time); }
+  /**
+   * @brief Update the entity again from the next tick on
+   */
+  virtual void wake() { return sub->wake(); }
+  /**
+   * @brief Check if the entity is sleeping
+   * @return True if the entity's updates are skipped
+   */
+  virtual bool isAsleep() const { return sub->isAsleep(); }
+  /**
+   * @brief Bring the entity up to date after it slept
+   * @param seconds Simulation time the entity slept through
+   * @param ticks Number of ticks the entity slept through
+   */
+  virtual void fastForward(double seconds, long ticks) {
+    return sub->fastForward(seconds, ticks);
+  }
   /**
    * @brief Add an observer to the entity
    * @param o The observer to add
@@ -108,6 +136,16 @@ class IEntityDecorator : public T {
   virtual void notifyObservers(const std::string& message) {
     return sub->notifyObservers(message);
   };
+  /**
+   * @brief Write the state of the decorated entity to a snapshot
+   * @param out The snapshot to write to
+   */
+  virtual void save(SnapshotWriter& out) const { return sub->save(out); }
+  /**
+   * @brief Read the state written by save()
+   * @param in The snapshot to read from
+   */
+  virtual void load(SnapshotReader& in) { return sub->load(in); }
 
  protected:
   T* sub = nullptr;
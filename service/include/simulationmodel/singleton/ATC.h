@@ -1,66 +1,207 @@
 #ifndef ATC_H_
 #define ATC_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "AirplaneATCDecorator.h"
+#include "ConflictDetector.h"
 #include "DroneATCDecorator.h"
+#include "FlightSnapshot.h"
 #include "FlyingEntityDecorator.h"
 #include "HelicopterATCDecorator.h"
 #include "IEntity.h"
+#include "SpscQueue.h"
+#include "SweptCapsuleTree.h"
+
+class DataCollectionManager;
+class SnapshotReader;
+class SnapshotWriter;
+
 /**
  * @class ATC
- * @brief Implements singleton pattern and keep track of all fying objects,
- * avoiding collisions
+ * @brief Keeps track of all the flying objects of a simulation, avoiding
+ * collisions
+ *
+ * After every tick the simulation publishes a snapshot of the flying
+ * entities. Conflicts are evaluated against the latest snapshot on a
+ * dedicated ATC thread, and the resulting reroute and log commands come back
+ * through a lock-free queue that the simulation drains at the start of the
+ * next tick. In synchronous mode each snapshot is evaluated on the
+ * simulation thread instead, which makes runs reproducible.
  */
 class ATC : public IPublisher {
  public:
   /**
-   * @brief Get the instance of the ATC
-   * @return The instance of the ATC
+   * @brief Constructor
+   * @param dataCollection Metrics the ATC logs to
+   * @param store Entity store the flying entities live in
+   */
+  ATC(DataCollectionManager& dataCollection, EntityStore& store);
+
+  /**
+   * @brief Destructor, stops the ATC thread
+   */
+  ~ATC();
+
+  ATC(const ATC&) = delete;
+  ATC& operator=(const ATC&) = delete;
+
+  /**
+   * @brief Register a flying entity with the ATC
+   * @param entity The entity to track
+   * @return Handle identifying the registration, used to deregister it
+   */
+  int addEntity(IEntity* entity);
+
+  /**
+   * @brief Deregister a flying entity in O(1) by swapping it with the last
+   * registered entity. Unknown handles are ignored.
+   * @param handle Handle returned by addEntity
+   */
+  void removeEntity(int handle);
+
+  /**
+   * @brief Check whether a handle is currently registered
+   * @param handle Handle returned by addEntity
+   * @return True if the handle refers to a live registration
+   */
+  bool isRegistered(int handle) const;
+
+  /**
+   * @brief Get the number of registered flying entities
+   * @return Number of live registrations
+   */
+  size_t size() const;
+
+  /**
+   * @brief Tell the ATC that an entity changed route, so every pair it is
+   * part of is re-evaluated with the next snapshot. Required when an entity
+   * moves discontinuously (for example an airplane respawning).
+   * @param handle Handle returned by addEntity
+   */
+  void routeChanged(int handle);
+
+  /**
+   * @brief Find the flying entities that could conflict with a path in the
+   * next few seconds, for example to pick a conflict-free dispatch. Answers
+   * from the airspace capsules of the last update.
+   * @param position Start of the path
+   * @param velocity Velocity along the path
+   * @param time Seconds of the path to consider
+   * @param radius Clearance needed around the path
+   * @return Handles of the entities whose airspace the path enters
    */
-  static ATC& getInstance();
+  std::vector<int> conflictCandidates(const Vector3& position,
+                                      const Vector3& velocity, double time,
+                                      double radius);
 
   /**
-   * @brief Add an entity to the ATC
+   * @brief Apply the reroute and log commands the ATC has produced so far.
+   * Called on the simulation thread at the start of a tick.
    */
-  void addEntity(IEntity* entity);
+  void applyCommands();
 
   /**
-   * @brief Update the ATC
+   * @brief Publish a snapshot of the flying entities at the end of a tick
+   * and hand it to the ATC thread, or evaluate it right away in synchronous
+   * mode
+   * @param dt Time since the last update
    */
   void update(double dt);
 
- private:
   /**
-   * @brief Constructor
+   * @brief Switch between evaluating on the ATC thread and evaluating on the
+   * simulation thread. The thread is started on the next update.
+   * @param threaded True to evaluate on the ATC thread
    */
-  ATC();
+  void setThreaded(bool threaded);
+
   /**
-   * @brief Destructor
+   * @brief Check whether snapshots are evaluated on the ATC thread
+   * @return True in threaded mode
    */
-  ~ATC();
+  bool isThreaded() const;
+
   /**
-   * @brief Delete the copy constructor
+   * @brief Wait until the ATC thread has evaluated every published snapshot
+   * and is idle, then apply all the commands it produced. Until the next
+   * update nothing changes the ATC's state, so it can be saved. Called on
+   * the simulation thread between ticks.
    */
-  ATC(const ATC&) = delete;
+  void quiesce();
+
   /**
-   * @brief Delete the assignment operator
+   * @brief Write the ATC's clock, the order of the registrations and the
+   * open conflict episodes to a snapshot. Call between ticks, right after
+   * quiesce().
+   * @param out Snapshot to write to
    */
-  ATC& operator=(const ATC&) = delete;
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * @brief Read the state written by save(). Every saved registration must
+   * have been added again already.
+   * @param in Snapshot to read from
+   */
+  void load(SnapshotReader& in);
 
+ private:
   /**
-   * @brief Check if two entities will collide
+   * @brief Body of the ATC thread: evaluate each snapshot as it arrives
    */
-  bool willCollide(IEntity* a, IEntity* b);
+  void run();
 
   /**
-   * @brief Choose an entity to reroute
+   * @brief Stop and join the ATC thread if it is running
    */
-  IEntity* chooseEntity(int i, int j);
+  void stopThread();
 
-  static ATC instance;
+  /**
+   * @brief Run conflict detection on a snapshot and queue its commands
+   * @param snapshot Snapshot to evaluate
+   * @param onSimulationThread True in synchronous mode, where a full queue
+   * is drained in place instead of waited on
+   */
+  void evaluate(const FlightSnapshot& snapshot, bool onSimulationThread);
+
+  DataCollectionManager& dataCollection;
+  EntityStore& store;
+  // Dense storage of live entities; handles[i] is the handle of
+  // flyingEntities[i], and slots maps a handle back to its index.
   std::vector<IEntity*> flyingEntities;
+  std::vector<int> handles;
+  std::unordered_map<int, size_t> slots;
+  double simTime = 0;
+  unsigned long appliedCommands = 0;
+
+  // airspace capsules for conflictCandidates, refit on the first query after
+  // an update
+  SweptCapsuleTree airspace;
+  bool airspaceStale = true;
+
+  // back is filled by the simulation, published is the latest snapshot
+  // waiting for the ATC thread and working the one it is evaluating
+  FlightSnapshot back;
+  FlightSnapshot published;
+  FlightSnapshot working;
+  bool snapshotFresh = false;
+  // true while the ATC thread evaluates working outside the lock
+  bool evaluating = false;
+  std::atomic<bool> stopping{false};
+  std::mutex snapshotMutex;
+  std::condition_variable snapshotReady;
+  std::condition_variable workerIdle;
+
+  bool threaded = true;
+  std::thread worker;
+  ConflictDetector detector;
+  std::vector<ATCCommand> output;
+  SpscQueue<ATCCommand> commands;
 };
 
 #endif
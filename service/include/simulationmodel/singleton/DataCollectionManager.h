@@ -12,25 +12,29 @@
 #include "IEntity.h"
 #include "IPublisher.h"
 
+class SnapshotReader;
+class SnapshotWriter;
+
 /**
  * @class DataCollectionManager
- * @brief Singleton class implementing IDataLogger for logging and IPublisher
- * for notifications
+ * @brief Class implementing IDataLogger for logging and IPublisher for
+ * notifications
  *
  * The DataCollectionManager provides centralized tracking and logging of entity
  * metrics throughout the simulation. It stores event data by entity ID and can
- * export this data to CSV files for analysis.
+ * export this data to CSV files for analysis. Each simulation has its own,
+ * reached through its SimulationContext.
  */
 
 class DataCollectionManager : public IDataLogger, public IPublisher {
  public:
   /**
-   * @brief Gets the singleton instance of DataCollectionManager
-   * @return Pointer to the single DataCollectionManager instance
-   *
-   * If the instance doesn't exist yet, it creates one before returning
+   * @brief Constructor
    */
-  static DataCollectionManager* getInstance();
+  DataCollectionManager() {}
+
+  DataCollectionManager(const DataCollectionManager&) = delete;
+  DataCollectionManager& operator=(const DataCollectionManager&) = delete;
 
   /**
    * @brief Exports the simulation log to a CSV file
@@ -61,6 +65,18 @@ class DataCollectionManager : public IDataLogger, public IPublisher {
    */
   void logEvent(IEntity* entity, std::string eventName, double metric) override;
 
+  /**
+   * @brief Records a metric that keeps its smallest value for an entity
+   * @param entity Pointer to the entity generating the event
+   * @param eventName Name of the metric being recorded
+   * @param metric Value to compare against the current minimum
+   *
+   * If the metric already exists for this entity, it is replaced only when
+   * the new value is smaller. Otherwise, a new metric entry is created.
+   */
+  void logMinimum(IEntity* entity, std::string eventName,
+                  double metric) override;
+
   /**
    * @brief Removes an entity from the logging system
    * @param entity Pointer to the entity to remove
@@ -69,15 +85,29 @@ class DataCollectionManager : public IDataLogger, public IPublisher {
    */
   void removeEntity(IEntity* entity) override;
 
- private:
   /**
-   * @brief Private constructor prevents direct instantiation
+   * @brief Records a metric event for a simulation subsystem
+   * @param component Name of the subsystem generating the event
+   * @param eventName Name of the metric being recorded
+   * @param metric Value of the metric to add
    *
-   * Part of the singleton pattern implementation
+   * Subsystem metrics are exported alongside entity metrics, using the
+   * component name as the entity name and -1 as the id.
    */
-  DataCollectionManager() {}
+  void logSystemEvent(const std::string& component,
+                      const std::string& eventName, double metric) override;
 
-  static DataCollectionManager* instance;
+  /**
+   * @brief Writes every logged metric to a snapshot
+   * @param out Snapshot to write to
+   */
+  void save(SnapshotWriter& out) const;
+
+  /**
+   * @brief Replaces the logged metrics with the ones written by save()
+   * @param in Snapshot to read from
+   */
+  void load(SnapshotReader& in);
 };
 
 #endif  // IDATACOLLECTIONMANAGER_H_
\ No newline at end of file
@@ -16,6 +16,17 @@ class BeelineStrategy : public PathStrategy {
    * @param des End destination
    */
   BeelineStrategy(Vector3 pos, Vector3 des);
+
+  /**
+   * @brief Make a beeline in the strategy pool of an entity's simulation;
+   * for code that cannot see the simulation context
+   *
+   * @param entity Entity that will follow the beeline
+   * @param pos Starting position
+   * @param des End destination
+   * @return Handle owning the beeline
+   */
+  static StrategyHandle create(IEntity* entity, Vector3 pos, Vector3 des);
 };
 
 #endif  // BEELINE_H_
@@ -24,6 +24,13 @@ class IStrategy {
    * @return True if complete, false if not complete
    */
   virtual bool isCompleted() = 0;
+
+  /**
+   * @brief Write the progress of the trip to a snapshot
+   *
+   * @param out Snapshot to write to
+   */
+  virtual void save(SnapshotWriter& out) const = 0;
 };
 
 #endif
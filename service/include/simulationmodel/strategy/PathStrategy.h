@@ -2,16 +2,61 @@
 #define PATH_STRATEGY_H_
 
 #include "IStrategy.h"
+#include "StrategyPool.h"
 
 /**
  * @brief this class inhertis from the IStrategy class and is represents
  * a movement strategy where the entity simply moves along the given path
+ *
+ * The path is walked by arc length: each step the entity covers exactly
+ * speed * dt along the path, past as many waypoints as that takes, so a
+ * step of any size lands on the path without overshooting. The trip counts
+ * as completed once the entity is within arrivalRadius of the end.
+ *
+ * While the entity is on a straight stretch of the path, the strategy leaves
+ * the stretch in the entity store, and the next move takes the position
+ * EntityStore::walkPaths() already worked out for every follower at once.
  */
 class PathStrategy : public IStrategy {
  protected:
   std::vector<Vector3> path;
   int index;
 
+ private:
+  /**
+   * @brief Measure the path; subclasses fill in the path after this class
+   * is constructed, so this runs on the first move
+   * @param pool Pool of the entity's simulation, lends the buffer
+   */
+  void measure(StrategyPool& pool);
+
+  /**
+   * @brief Leave the stretch up to the next waypoint in the entity store
+   * @param store Store of the entity's simulation
+   * @param id Id of the entity that walks it
+   */
+  void arm(EntityStore& store, int id);
+
+  /**
+   * @brief Take the stretch out of the entity store again
+   */
+  void disarm();
+
+  static constexpr double arrivalRadius = 4;
+
+  // distance along the path from the first waypoint to each waypoint, in a
+  // buffer borrowed from lengthPool
+  std::vector<double> arcLength;
+  StrategyPool* lengthPool = nullptr;
+  // how far along the path the entity is, and where the last move left it
+  double travelled = 0;
+  Vector3 resume;
+  bool onPath = false;
+  // tells this strategy's stretch apart in the store, and the entity it is on
+  unsigned long token;
+  int walker = -1;
+  EntityStore* walkStore = nullptr;
+
  public:
   /**
    * @brief Construct a new PathStrategy Strategy object
@@ -20,6 +65,15 @@ class PathStrategy : public IStrategy {
    */
   PathStrategy(std::vector<Vector3> path = {});
 
+  PathStrategy(const PathStrategy&) = delete;
+  PathStrategy& operator=(const PathStrategy&) = delete;
+
+  /**
+   * @brief Destructor, takes the stretch out of the entity store and gives
+   * the buffer of the arc lengths back
+   */
+  virtual ~PathStrategy();
+
   /**
    * @brief Move toward next position in the path
    *
@@ -35,6 +89,33 @@ class PathStrategy : public IStrategy {
    * @return True if complete, false if not complete
    */
   virtual bool isCompleted();
+
+  /**
+   * @brief Write the path and how far along it the entity is. The search
+   * that found the path is not repeated on restore.
+   *
+   * @param out Snapshot to write to
+   */
+  virtual void save(SnapshotWriter& out) const;
+
+  /**
+   * @brief Write a strategy that may be null
+   *
+   * @param out Snapshot to write to
+   * @param strategy The strategy, may be empty
+   */
+  static void save(SnapshotWriter& out, const StrategyHandle& strategy);
+
+  /**
+   * @brief Read a strategy written by save(out, strategy). The stretch the
+   * entity was walking goes back into the entity store, so the restored
+   * strategy takes the same steps the saved one would have.
+   *
+   * @param in Snapshot to read from
+   * @param entity Entity that follows the strategy
+   * @return The strategy, made by the entity's pool; empty if none was saved
+   */
+  static StrategyHandle load(SnapshotReader& in, IEntity* entity);
 };
 
 #endif  // PATH_STRATEGY_H_
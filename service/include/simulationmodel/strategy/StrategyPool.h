@@ -0,0 +1,139 @@
+#ifndef STRATEGY_POOL_H_
+#define STRATEGY_POOL_H_
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "BlockPool.h"
+
+class IStrategy;
+class StrategyPool;
+
+/**
+ * @class StrategyHandle
+ * @brief Owns a movement strategy made by a StrategyPool and gives it back
+ * to the pool when it goes out of scope or is replaced.
+ */
+class StrategyHandle {
+ public:
+  StrategyHandle() = default;
+  StrategyHandle(std::nullptr_t) {}
+  StrategyHandle(StrategyHandle&& other);
+  StrategyHandle& operator=(StrategyHandle&& other);
+  StrategyHandle(const StrategyHandle&) = delete;
+  StrategyHandle& operator=(const StrategyHandle&) = delete;
+
+  /**
+   * @brief Destructor, gives the strategy back to its pool
+   */
+  ~StrategyHandle();
+
+  /**
+   * @brief Give the strategy back to its pool now
+   */
+  void reset();
+
+  /**
+   * @brief Get the strategy
+   * @return The strategy, nullptr if the handle is empty
+   */
+  IStrategy* get() const { return strategy; }
+
+  IStrategy* operator->() const { return strategy; }
+  explicit operator bool() const { return strategy != nullptr; }
+
+ private:
+  friend class StrategyPool;
+
+  StrategyHandle(IStrategy* strategy, StrategyPool* pool)
+      : strategy(strategy), pool(pool) {}
+
+  IStrategy* strategy = nullptr;
+  StrategyPool* pool = nullptr;
+};
+
+/**
+ * @class StrategyPool
+ * @brief Recycles the memory of one simulation's movement strategies.
+ *
+ * Every trip, reroute and wander makes a new strategy, so the pool keeps the
+ * blocks of finished strategies, and the buffers of their measured paths,
+ * for the next ones instead of going through the allocator each time. All
+ * strategies fit one block size. Strategies are made and dropped on the
+ * worker threads of the entity update too, so the spare buffers are locked
+ * like the blocks.
+ */
+class StrategyPool {
+ public:
+  StrategyPool();
+  StrategyPool(const StrategyPool&) = delete;
+  StrategyPool& operator=(const StrategyPool&) = delete;
+
+  /**
+   * @brief Make a strategy in a pooled block
+   * @tparam T Type of the strategy
+   * @param args Arguments of the strategy's constructor
+   * @return Handle owning the strategy
+   */
+  template <typename T, typename... Args>
+  StrategyHandle make(Args&&... args) {
+    static_assert(sizeof(T) <= blockSize, "strategy does not fit a block");
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "strategy is overaligned");
+    void* block = blocks.allocate();
+    try {
+      return StrategyHandle(new (block) T(std::forward<Args>(args)...), this);
+    } catch (...) {
+      // a search that finds no path throws from the constructor
+      blocks.deallocate(block);
+      throw;
+    }
+  }
+
+  /**
+   * @brief Take a buffer for the arc lengths of a path
+   * @return An empty buffer, with room from an earlier path if one was
+   * given back
+   */
+  std::vector<double> takeLengths();
+
+  /**
+   * @brief Give back a buffer taken with takeLengths()
+   * @param lengths The buffer
+   */
+  void giveLengths(std::vector<double>&& lengths);
+
+  /**
+   * @brief Get the number of blocks the pool has allocated
+   * @return Blocks in use or free
+   */
+  size_t getCapacity() const;
+
+  /**
+   * @brief Get the number of strategies alive
+   * @return Blocks in use
+   */
+  size_t getInUse() const;
+
+ private:
+  friend class StrategyHandle;
+
+  static constexpr size_t blockSize = 192;
+  // more spare buffers than this are freed
+  static constexpr size_t maxSpareLengths = 256;
+
+  /**
+   * @brief Destroy a strategy and free its block
+   * @param strategy The strategy
+   */
+  void release(IStrategy* strategy);
+
+  BlockPool blocks;
+  std::mutex mutex;
+  std::vector<std::vector<double>> spareLengths;
+};
+
+#endif  // STRATEGY_POOL_H_
@@ -0,0 +1,69 @@
+#ifndef BLOCK_POOL_H_
+#define BLOCK_POOL_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @class BlockPool
+ * @brief Hands out memory blocks of one size from chunks, and keeps freed
+ * blocks for the next request instead of returning them to the heap.
+ *
+ * Objects that are created and freed all the time then reuse the same
+ * memory, so the heap neither fragments nor grows past the most objects
+ * alive at once. Blocks are only released when the pool is destroyed. Any
+ * thread may allocate and free; the free list is locked.
+ */
+class BlockPool {
+ public:
+  /**
+   * @brief Constructor
+   * @param size Bytes in a block
+   * @param blocksPerChunk Blocks allocated from the heap at once
+   */
+  explicit BlockPool(size_t size, size_t blocksPerChunk = 64);
+
+  BlockPool(const BlockPool&) = delete;
+  BlockPool& operator=(const BlockPool&) = delete;
+
+  /**
+   * @brief Get a free block, allocating a chunk of them if none is left
+   * @return A block aligned for any fundamental type
+   */
+  void* allocate();
+
+  /**
+   * @brief Put a block back on the free list
+   * @param block A block from allocate()
+   */
+  void deallocate(void* block);
+
+  /**
+   * @brief Get the size of a block
+   * @return Bytes in a block
+   */
+  size_t getBlockSize() const;
+
+  /**
+   * @brief Get the number of blocks the pool has allocated
+   * @return Blocks in use or free
+   */
+  size_t getCapacity() const;
+
+  /**
+   * @brief Get the number of blocks handed out and not freed
+   * @return Blocks in use
+   */
+  size_t getInUse() const;
+
+ private:
+  size_t blockSize;
+  size_t blocksPerChunk;
+  mutable std::mutex mutex;
+  std::vector<std::unique_ptr<std::max_align_t[]>> chunks;
+  std::vector<void*> freeBlocks;
+};
+
+#endif  // BLOCK_POOL_H_
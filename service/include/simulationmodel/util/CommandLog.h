@@ -0,0 +1,134 @@
+#ifndef COMMAND_LOG_H_
+#define COMMAND_LOG_H_
+
+#include <fstream>
+#include <string>
+
+#include "util/json.h"
+
+/**
+ * @brief Settings a recorded session ran with, written at the top of the log
+ */
+struct CommandLogHeader {
+  // seed of the simulation's random numbers
+  unsigned seed = 1;
+  // seconds per tick
+  double step = 0.01;
+  // whether the ATC evaluated on the simulation thread
+  bool syncATC = false;
+  // whether delivered packages and their robots were removed
+  bool retireDelivered = false;
+};
+
+/**
+ * @brief A command and the tick it ran at
+ */
+struct CommandLogEntry {
+  long tick = 0;
+  std::string command;
+  JsonObject params;
+};
+
+/**
+ * @class CommandRecorder
+ * @brief Writes the commands that change a simulation to a log, with the
+ * tick each one ran at, so the session can be replayed.
+ *
+ * The log has one JSON object per line: the header first, then the entries.
+ * Update commands only advance the clock, so only the tick the last one
+ * reached is written, right before the next command and when the recorder
+ * closes. Every line is flushed, so a log survives a crash up to the last
+ * command.
+ */
+class CommandRecorder {
+ public:
+  /**
+   * @brief Constructor
+   * @param path File to write, replaced if it exists
+   * @param header Settings of the session
+   */
+  CommandRecorder(const std::string& path, const CommandLogHeader& header);
+
+  /**
+   * @brief Destructor, writes the tick the last update reached
+   */
+  ~CommandRecorder();
+
+  CommandRecorder(const CommandRecorder&) = delete;
+  CommandRecorder& operator=(const CommandRecorder&) = delete;
+
+  /**
+   * @brief Check whether the log could be opened
+   * @return True if commands are written
+   */
+  bool isOpen() const;
+
+  /**
+   * @brief Record a command before it runs
+   * @param tick Ticks the simulation has run when the command arrives
+   * @param command Name of the command
+   * @param params Parameters of the command
+   */
+  void record(long tick, const std::string& command, const JsonObject& params);
+
+  /**
+   * @brief Record that the simulation has run up to a tick
+   * @param tick Ticks the simulation has run
+   */
+  void advance(long tick);
+
+  /**
+   * @brief Check whether a command changes the simulation and so belongs in
+   * the log. Queries, pings and updates do not.
+   * @param command Name of the command
+   * @return True if the command is recorded
+   */
+  static bool changesSimulation(const std::string& command);
+
+ private:
+  void write(const CommandLogEntry& entry);
+  void flushUpdate();
+
+  std::ofstream file;
+  long written = 0;
+  long reached = 0;
+};
+
+/**
+ * @class CommandReader
+ * @brief Reads a log written by CommandRecorder, entry by entry
+ */
+class CommandReader {
+ public:
+  /**
+   * @brief Constructor, reads the header
+   * @param path Log to read
+   */
+  explicit CommandReader(const std::string& path);
+
+  /**
+   * @brief Check whether the log could be opened and has a header
+   * @return True if entries can be read
+   */
+  bool isOpen() const;
+
+  /**
+   * @brief Get the settings of the recorded session
+   * @return The header of the log
+   */
+  const CommandLogHeader& getHeader() const;
+
+  /**
+   * @brief Read the next entry
+   * @param entry Receives the entry
+   * @return False at the end of the log or on a line that does not parse
+   */
+  bool next(CommandLogEntry& entry);
+
+ private:
+  std::ifstream file;
+  CommandLogHeader header;
+  bool valid = false;
+};
+
+#endif  // COMMAND_LOG_H_
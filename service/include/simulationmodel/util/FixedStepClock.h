@@ -0,0 +1,80 @@
+#ifndef FIXED_STEP_CLOCK_H_
+#define FIXED_STEP_CLOCK_H_
+
+/**
+ * @class FixedStepClock
+ * @brief Turns variable frame times into a whole number of fixed simulation
+ * steps.
+ *
+ * Elapsed time is collected in an accumulator and paid out in steps of
+ * exactly the same length, so the simulation behaves the same at any frame
+ * rate. Simulation time is the number of steps taken times the step, which
+ * never drifts. After a stall, at most maxSteps steps per frame are run at
+ * normal speed, and proportionally more at higher speeds, and the rest of the
+ * backlog is dropped: the simulation falls behind wall time instead of
+ * spending ever longer frames catching up.
+ */
+class FixedStepClock {
+ public:
+  /**
+   * @brief Constructor
+   * @param step Length of a simulation step in seconds
+   * @param maxSteps Most steps to run for a single frame at normal speed
+   */
+  explicit FixedStepClock(double step = 0.01, int maxSteps = 25);
+
+  /**
+   * @brief Add the simulation time that passed since the last frame
+   * @param elapsed Wall-clock seconds since the last frame
+   * @param speed Simulated seconds per wall-clock second; the per-frame
+   * step cap grows with it, so a frame at any speed may run as long
+   * @return Number of steps to run this frame
+   */
+  int advance(double elapsed, double speed = 1.0);
+
+  /**
+   * @brief Get the length of a step
+   * @return Seconds per step
+   */
+  double getStep() const;
+
+  /**
+   * @brief Get the most steps run for a single frame at normal speed
+   * @return Maximum catch-up steps
+   */
+  int getMaxSteps() const;
+
+  /**
+   * @brief Set the most steps run for a single frame at normal speed
+   * @param maxSteps Maximum catch-up steps, at least one
+   */
+  void setMaxSteps(int maxSteps);
+
+  /**
+   * @brief Get the simulation time of the last step handed out
+   * @return Seconds of simulated time
+   */
+  double getTime() const;
+
+  /**
+   * @brief Get how far the frame is between the last step and the next one,
+   * for interpolating what is drawn
+   * @return Fraction of a step in [0, 1)
+   */
+  double getAlpha() const;
+
+  /**
+   * @brief Get the time dropped because frames needed more than maxSteps
+   * @return Seconds of simulated time that were skipped
+   */
+  double getDroppedTime() const;
+
+ private:
+  double step;
+  int maxSteps;
+  unsigned long steps = 0;
+  double accumulator = 0;
+  double droppedTime = 0;
+};
+
+#endif  // FIXED_STEP_CLOCK_H_
@@ -0,0 +1,136 @@
+#ifndef ID_MAP_H_
+#define ID_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @class IdMap
+ * @brief Hash map from entity ids to values, sized by the ids it holds
+ * rather than by the largest id ever handed out.
+ *
+ * Ids only grow over a simulation, so a plain array indexed by id grows with
+ * every entity a long run creates, even when old ones are gone. The map uses
+ * open addressing with linear probing over a power-of-two table, and ids
+ * hash to themselves: ids handed out one after another land in neighbouring
+ * buckets, so a lookup is about as cheap as the array read it replaces.
+ * Erasing shifts the rest of the probe run back into the hole instead of
+ * leaving a tombstone, so the table never fills up with dead buckets under
+ * steady churn. The table grows to keep at most half of it in use and never
+ * shrinks.
+ */
+template <typename T>
+class IdMap {
+ public:
+  /**
+   * @brief Add a value under an id. Adding an id twice or a negative id is
+   * ignored.
+   * @param id The id
+   * @param value The value
+   * @return True if the value was added
+   */
+  bool insert(int id, T value) {
+    if (id < 0 || contains(id)) return false;
+    if (2 * (count + 1) > keys.size()) grow();
+    size_t bucket = home(id);
+    while (keys[bucket] != empty) bucket = next(bucket);
+    keys[bucket] = id;
+    values[bucket] = std::move(value);
+    ++count;
+    return true;
+  }
+
+  /**
+   * @brief Remove the value of an id. Unknown ids are ignored.
+   * @param id The id
+   * @return True if a value was removed
+   */
+  bool erase(int id) {
+    size_t hole = locate(id);
+    if (hole == npos) return false;
+    // move back every later entry of the probe run whose home bucket is not
+    // between the hole and itself, so lookups never stop early at the hole
+    for (size_t bucket = next(hole); keys[bucket] != empty;
+         bucket = next(bucket)) {
+      size_t mask = keys.size() - 1;
+      if (((bucket - home(keys[bucket])) & mask) >= ((bucket - hole) & mask)) {
+        keys[hole] = keys[bucket];
+        values[hole] = std::move(values[bucket]);
+        hole = bucket;
+      }
+    }
+    keys[hole] = empty;
+    values[hole] = T();
+    --count;
+    return true;
+  }
+
+  /**
+   * @brief Check whether an id has a value
+   * @param id The id
+   * @return True if the id is in the map
+   */
+  bool contains(int id) const { return locate(id) != npos; }
+
+  /**
+   * @brief Look up the value of an id
+   * @param id The id
+   * @return The value, nullptr if the id is not in the map
+   */
+  T* get(int id) {
+    size_t bucket = locate(id);
+    return bucket != npos ? &values[bucket] : nullptr;
+  }
+  const T* get(int id) const {
+    size_t bucket = locate(id);
+    return bucket != npos ? &values[bucket] : nullptr;
+  }
+
+  /**
+   * @brief Get the number of ids
+   * @return Ids in the map
+   */
+  size_t size() const { return count; }
+
+ private:
+  static constexpr int empty = -1;
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  size_t home(int id) const {
+    return static_cast<size_t>(id) & (keys.size() - 1);
+  }
+
+  size_t next(size_t bucket) const { return (bucket + 1) & (keys.size() - 1); }
+
+  // bucket of an id, npos if the id is not in the map
+  size_t locate(int id) const {
+    if (id < 0 || keys.empty()) return npos;
+    for (size_t bucket = home(id); keys[bucket] != empty;
+         bucket = next(bucket)) {
+      if (keys[bucket] == id) return bucket;
+    }
+    return npos;
+  }
+
+  void grow() {
+    std::vector<int> oldKeys(std::max<size_t>(16, 2 * keys.size()), empty);
+    std::vector<T> oldValues(oldKeys.size());
+    keys.swap(oldKeys);
+    values.swap(oldValues);
+    count = 0;
+    for (size_t bucket = 0; bucket < oldKeys.size(); ++bucket) {
+      if (oldKeys[bucket] != empty) {
+        insert(oldKeys[bucket], std::move(oldValues[bucket]));
+      }
+    }
+  }
+
+  // id in each bucket, empty for free buckets
+  std::vector<int> keys;
+  std::vector<T> values;
+  size_t count = 0;
+};
+
+#endif  // ID_MAP_H_
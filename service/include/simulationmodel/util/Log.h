@@ -0,0 +1,102 @@
+#ifndef LOG_H_
+#define LOG_H_
+
+#include <sstream>
+#include <string>
+
+/**
+ * @brief Importance of a log message
+ */
+enum class LogLevel { Debug, Info, Warning, Error, Off };
+
+// Messages below this level are compiled out: 0 keeps debug messages, 1 keeps
+// info and up, and so on. Release builds drop debug messages by default.
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL 1
+#else
+#define LOG_MIN_LEVEL 0
+#endif
+#endif
+
+/**
+ * @class Log
+ * @brief Leveled log whose messages are written by a background thread.
+ *
+ * Logging formats the message on the calling thread and pushes it into a
+ * lock-free ring buffer, so the simulation never waits for the console. The
+ * writer thread starts with the first message and sends info and debug
+ * messages to standard output, warnings and errors to standard error. When
+ * the buffer is full messages are dropped and counted instead.
+ *
+ * Log through the LOG_DEBUG, LOG_INFO, LOG_WARNING and LOG_ERROR macros,
+ * which take a stream expression and skip formatting for disabled levels:
+ *
+ *   LOG_INFO(name << ": " << position);
+ */
+class Log {
+ public:
+  /**
+   * @brief Set the lowest level that is written
+   * @param level The level; Off silences the log
+   */
+  static void setLevel(LogLevel level);
+
+  /**
+   * @brief Get the lowest level that is written
+   * @return The level
+   */
+  static LogLevel getLevel();
+
+  /**
+   * @brief Check whether messages of a level are written
+   * @param level The level
+   * @return True if the level is at or above the current level
+   */
+  static bool enabled(LogLevel level);
+
+  /**
+   * @brief Queue a message for the writer thread
+   * @param level Level of the message
+   * @param message The message, without a trailing newline
+   */
+  static void write(LogLevel level, const std::string& message);
+
+  /**
+   * @brief Wait until every message queued so far has been written; for
+   * output that has to come after the log, not for hot paths
+   */
+  static void flush();
+
+  /**
+   * @brief Get the number of messages dropped on a full buffer
+   * @return Dropped messages since the start
+   */
+  static unsigned long getDropped();
+
+  /**
+   * @brief Read a level from its name
+   * @param name debug, info, warning, error or off
+   * @param level Receives the level
+   * @return False if the name is unknown
+   */
+  static bool parseLevel(const std::string& name, LogLevel& level);
+};
+
+#define LOG_AT(level, message)                                 \
+  do {                                                         \
+    if constexpr (static_cast<int>(level) >= LOG_MIN_LEVEL) {  \
+      if (Log::enabled(level)) {                               \
+        std::ostringstream logMessage;                         \
+        logMessage << message;                                 \
+        Log::write(level, logMessage.str());                   \
+      }                                                        \
+    }                                                          \
+  } while (0)
+
+#define LOG_DEBUG(message) LOG_AT(LogLevel::Debug, message)
+#define LOG_INFO(message) LOG_AT(LogLevel::Info, message)
+#define LOG_WARNING(message) LOG_AT(LogLevel::Warning, message)
+#define LOG_ERROR(message) LOG_AT(LogLevel::Error, message)
+
+#endif  // LOG_H_
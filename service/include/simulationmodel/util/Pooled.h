@@ -0,0 +1,56 @@
+#ifndef POOLED_H_
+#define POOLED_H_
+
+#include <cstddef>
+#include <new>
+
+#include "BlockPool.h"
+
+/**
+ * @class Pooled
+ * @brief Base that makes new and delete of a class take its objects from a
+ * BlockPool of its own.
+ *
+ * Classes that are created and retired all the time derive from
+ * Pooled<Self>, and plain new and delete expressions, including delete
+ * through a base pointer, reuse the blocks of retired objects. The
+ * constructor runs on every reuse, so a recycled object starts out exactly
+ * like a new one. Subclasses of a pooled class that are larger than it fall
+ * back to the heap.
+ *
+ * @tparam T The pooled class
+ */
+template <typename T>
+class Pooled {
+ public:
+  static void* operator new(size_t size) {
+    if (size != sizeof(T) || alignof(T) > alignof(std::max_align_t)) {
+      return ::operator new(size);
+    }
+    return pool().allocate();
+  }
+
+  static void operator delete(void* block, size_t size) {
+    if (size != sizeof(T) || alignof(T) > alignof(std::max_align_t)) {
+      ::operator delete(block);
+      return;
+    }
+    pool().deallocate(block);
+  }
+
+  /**
+   * @brief Get the pool of the class
+   * @return The pool, shared by every simulation in the process
+   */
+  static BlockPool& pool() {
+    // never destroyed, so objects freed during static destruction still
+    // find it
+    static BlockPool* blocks = new BlockPool(sizeof(T));
+    return *blocks;
+  }
+
+ protected:
+  Pooled() = default;
+};
+
+#endif  // POOLED_H_
@@ -0,0 +1,122 @@
+#ifndef RING_BUFFER_H_
+#define RING_BUFFER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/**
+ * @class RingBuffer
+ * @brief Bounded queue that any number of threads push to and pop from
+ * without locks.
+ *
+ * Every cell carries a sequence number that says whether it waits for a push
+ * or a pop of the current lap, so a thread claims a cell with one
+ * compare-and-swap on the shared position and then fills or empties it
+ * without disturbing the other threads. A push into a full buffer fails
+ * instead of waiting.
+ */
+template <typename T>
+class RingBuffer {
+ public:
+  /**
+   * @brief Constructor
+   * @param capacity Elements the buffer holds; rounded up to a power of two
+   */
+  explicit RingBuffer(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    cells = std::make_unique<Cell[]>(size);
+    mask = size - 1;
+    for (size_t i = 0; i < size; i++) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  /**
+   * @brief Add an element at the back
+   * @param value The element
+   * @return False if the buffer is full
+   */
+  bool tryPush(const T& value) {
+    size_t position = pushes.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells[position & mask];
+      size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      std::intptr_t lag = static_cast<std::intptr_t>(sequence) -
+                          static_cast<std::intptr_t>(position);
+      if (lag == 0) {
+        if (pushes.compare_exchange_weak(position, position + 1,
+                                         std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (lag < 0) {
+        // the cell still holds the element of the last lap
+        return false;
+      } else {
+        position = pushes.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = value;
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Take the element at the front
+   * @param value Receives the element
+   * @return False if the buffer is empty, or the front element is still
+   * being pushed
+   */
+  bool tryPop(T& value) {
+    size_t position = pops.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells[position & mask];
+      size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      std::intptr_t lag = static_cast<std::intptr_t>(sequence) -
+                          static_cast<std::intptr_t>(position + 1);
+      if (lag == 0) {
+        if (pops.compare_exchange_weak(position, position + 1,
+                                       std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (lag < 0) {
+        return false;
+      } else {
+        position = pops.load(std::memory_order_relaxed);
+      }
+    }
+    value = std::move(cell->value);
+    // hand the cell to the push of the next lap
+    cell->sequence.store(position + mask + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Get the number of elements the buffer holds
+   * @return Capacity, a power of two
+   */
+  size_t capacity() const { return mask + 1; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> cells;
+  size_t mask;
+  // kept on separate cache lines so pushing threads do not slow the popping
+  // ones down
+  alignas(64) std::atomic<size_t> pushes{0};
+  alignas(64) std::atomic<size_t> pops{0};
+};
+
+#endif  // RING_BUFFER_H_
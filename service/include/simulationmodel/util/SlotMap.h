@@ -0,0 +1,160 @@
+#ifndef SLOT_MAP_H_
+#define SLOT_MAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @class SlotMap
+ * @brief Container with O(1) insert, erase and lookup, dense iteration, and
+ * handles that notice when the element they named is gone.
+ *
+ * Values live contiguously, and an erase moves the last value into the hole.
+ * A handle names a slot and the generation of the slot it was issued for;
+ * erasing bumps the generation, so old handles of a reused slot stop
+ * resolving instead of reaching the new value. Freed slots are reused in the
+ * order they were freed.
+ */
+template <typename T>
+class SlotMap {
+ public:
+  /**
+   * @brief Names an element of the map; a default handle names nothing
+   */
+  struct Handle {
+    std::uint32_t slot = npos;
+    std::uint32_t generation = 0;
+
+    bool operator==(const Handle& other) const = default;
+  };
+
+  /**
+   * @brief Add an element
+   * @param value The element
+   * @return Handle of the element
+   */
+  Handle insert(T value) {
+    std::uint32_t slot;
+    if (freeHead != npos) {
+      slot = freeHead;
+      freeHead = slots[slot].next;
+      if (freeHead == npos) freeTail = npos;
+    } else {
+      slot = static_cast<std::uint32_t>(slots.size());
+      slots.push_back({});
+    }
+    slots[slot].index = static_cast<std::uint32_t>(values.size());
+    values.push_back(std::move(value));
+    owners.push_back(slot);
+    return {slot, slots[slot].generation};
+  }
+
+  /**
+   * @brief Remove an element; stale handles are ignored
+   * @param handle Handle of the element
+   * @return True if an element was removed
+   */
+  bool erase(Handle handle) {
+    if (!contains(handle)) return false;
+    Slot& slot = slots[handle.slot];
+    std::uint32_t last = static_cast<std::uint32_t>(values.size() - 1);
+    if (slot.index != last) {
+      // move the last element into the hole
+      values[slot.index] = std::move(values[last]);
+      owners[slot.index] = owners[last];
+      slots[owners[slot.index]].index = slot.index;
+    }
+    values.pop_back();
+    owners.pop_back();
+
+    ++slot.generation;
+    slot.index = npos;
+    slot.next = npos;
+    if (freeTail != npos) {
+      slots[freeTail].next = handle.slot;
+    } else {
+      freeHead = handle.slot;
+    }
+    freeTail = handle.slot;
+    return true;
+  }
+
+  /**
+   * @brief Check whether a handle still names an element
+   * @param handle The handle
+   * @return True if the element is in the map
+   */
+  bool contains(Handle handle) const {
+    return handle.slot < slots.size() &&
+           slots[handle.slot].generation == handle.generation &&
+           slots[handle.slot].index != npos;
+  }
+
+  /**
+   * @brief Look up an element
+   * @param handle Handle of the element
+   * @return The element, nullptr if the handle is stale
+   */
+  T* get(Handle handle) {
+    return contains(handle) ? &values[slots[handle.slot].index] : nullptr;
+  }
+  const T* get(Handle handle) const {
+    return contains(handle) ? &values[slots[handle.slot].index] : nullptr;
+  }
+
+  /**
+   * @brief Get the number of elements
+   * @return Elements in the map
+   */
+  size_t size() const { return values.size(); }
+
+  /**
+   * @brief Check whether the map is empty
+   * @return True without elements
+   */
+  bool empty() const { return values.empty(); }
+
+  /**
+   * @brief Remove every element; all handles issued so far go stale
+   */
+  void clear() {
+    // erasing from the back moves nothing
+    while (!owners.empty()) {
+      erase({owners.back(), slots[owners.back()].generation});
+    }
+  }
+
+  /**
+   * @brief Iterate the elements in storage order, which is insertion order
+   * until an element is erased
+   */
+  typename std::vector<T>::iterator begin() { return values.begin(); }
+  typename std::vector<T>::iterator end() { return values.end(); }
+  typename std::vector<T>::const_iterator begin() const {
+    return values.begin();
+  }
+  typename std::vector<T>::const_iterator end() const { return values.end(); }
+
+ private:
+  static constexpr std::uint32_t npos = static_cast<std::uint32_t>(-1);
+
+  struct Slot {
+    // index of the element in values, npos while the slot is free
+    std::uint32_t index = npos;
+    std::uint32_t generation = 0;
+    // next free slot while the slot is free
+    std::uint32_t next = npos;
+  };
+
+  std::vector<T> values;
+  // slot of each element in values
+  std::vector<std::uint32_t> owners;
+  std::vector<Slot> slots;
+  // free slots, oldest first
+  std::uint32_t freeHead = npos;
+  std::uint32_t freeTail = npos;
+};
+
+#endif  // SLOT_MAP_H_
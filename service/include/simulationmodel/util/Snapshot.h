@@ -0,0 +1,101 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+/**
+ * @class SnapshotWriter
+ * @brief Writes the state of a simulation to a binary stream.
+ *
+ * A snapshot starts with a magic number and a format version, followed by
+ * the state in the order the model saves it. Values are written in the
+ * native byte order without padding, and nothing is ever sought back to, so
+ * a snapshot can go to a file, a pipe or a socket alike.
+ */
+class SnapshotWriter {
+ public:
+  /// Format version written by this build
+  static constexpr std::uint32_t version = 1;
+
+  /**
+   * @brief Constructor, writes the magic number and the version
+   * @param out Stream to write to
+   */
+  explicit SnapshotWriter(std::ostream& out);
+
+  /**
+   * @brief Write a value that can be copied byte by byte
+   * @param value The value
+   */
+  template <typename T>
+  void write(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  /**
+   * @brief Write a string, length first
+   * @param value The string
+   */
+  void write(const std::string& value);
+
+  /**
+   * @brief Check whether everything so far was written
+   * @return False once the stream failed
+   */
+  bool good() const;
+
+ private:
+  std::ostream& out;
+};
+
+/**
+ * @class SnapshotReader
+ * @brief Reads a snapshot written by SnapshotWriter, in the same order.
+ *
+ * Reading past the end of the stream or a snapshot of another format
+ * version throws std::runtime_error.
+ */
+class SnapshotReader {
+ public:
+  /**
+   * @brief Constructor, checks the magic number and the version
+   * @param in Stream to read from
+   * @throws std::runtime_error if the stream does not hold a snapshot this
+   * build can read
+   */
+  explicit SnapshotReader(std::istream& in);
+
+  /**
+   * @brief Read a value written with SnapshotWriter::write
+   * @return The value
+   */
+  template <typename T>
+  T read() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    check();
+    return value;
+  }
+
+  /**
+   * @brief Read a string written with SnapshotWriter::write
+   * @return The string
+   */
+  std::string readString();
+
+ private:
+  /**
+   * @brief Throw if the last read came up short
+   */
+  void check() const;
+
+  std::istream& in;
+};
+
+#endif  // SNAPSHOT_H_
@@ -0,0 +1,102 @@
+#ifndef SPATIAL_TILES_H_
+#define SPATIAL_TILES_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "EntityStore.h"
+
+/**
+ * @class SpatialTiles
+ * @brief Splits the ground plane into square tiles and sorts the entities of
+ * a tick into the tile each one stands over.
+ *
+ * A tile is the unit of work of the parallel entity update: one thread runs
+ * all the entities of a tile, so entities that are close to each other are
+ * handled together and threads do not write to the same parts of the store.
+ * An entity migrates when it is sorted into another tile than on the last
+ * tick. Tiles come out largest first, which balances the threads when the
+ * tiles are claimed one at a time.
+ */
+class SpatialTiles {
+ public:
+  /**
+   * @brief Constructor
+   * @param size Edge of a tile in meters; zero or less turns tiling off
+   */
+  explicit SpatialTiles(double size = 250);
+
+  /**
+   * @brief Change the edge of the tiles; every entity is sorted anew on the
+   * next assign()
+   * @param size Edge of a tile in meters; zero or less turns tiling off
+   */
+  void setSize(double size);
+
+  /**
+   * @brief Get the edge of the tiles
+   * @return Edge of a tile in meters, zero or less if tiling is off
+   */
+  double getSize() const;
+
+  /**
+   * @brief Check whether entities are split into tiles
+   * @return True if the tiles have a size
+   */
+  bool isEnabled() const;
+
+  /**
+   * @brief Sort entities into tiles by their positions in the store
+   * @param ids Ids of the entities, in ascending order
+   * @param store Store holding the entities' positions
+   * @return True if an entity joined, left or changed tile since the last
+   * call
+   */
+  bool assign(const std::vector<int>& ids, const EntityStore& store);
+
+  /**
+   * @brief Get the number of tiles that hold an entity
+   * @return Number of tiles from the last assign()
+   */
+  size_t size() const;
+
+  /**
+   * @brief Get the first entity of a tile
+   * @param tile Index of the tile, below size()
+   * @return Pointer to the indices into the ids given to assign(), which
+   * run in ascending order up to end(tile)
+   */
+  const size_t* begin(size_t tile) const;
+
+  /**
+   * @brief Get the end of the entities of a tile
+   * @param tile Index of the tile, below size()
+   * @return Pointer past the last index of the tile
+   */
+  const size_t* end(size_t tile) const;
+
+  /**
+   * @brief Get the number of times an entity moved to another tile
+   * @return Migrations since construction
+   */
+  unsigned long getMigrations() const;
+
+ private:
+  /**
+   * @brief Get the tile a position falls in
+   * @param position The position
+   * @return Tile column and row packed into one key
+   */
+  std::int64_t key(const Vector3& position) const;
+
+  double edge;
+  // entities and their tiles on the last assign(), in id order
+  std::vector<int> ids;
+  std::vector<std::int64_t> keys;
+  // members of tile t are members[starts[t]] up to members[starts[t + 1]]
+  std::vector<size_t> members;
+  std::vector<size_t> starts;
+  unsigned long migrations = 0;
+};
+
+#endif  // SPATIAL_TILES_H_
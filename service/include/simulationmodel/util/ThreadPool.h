@@ -0,0 +1,80 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads that run data-parallel loops.
+ *
+ * The calling thread works on the loop as well, so a pool of size one runs
+ * everything inline.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @brief Start the workers
+   * @param threads Threads working on a loop, including the caller; zero
+   * picks one per hardware thread
+   */
+  explicit ThreadPool(size_t threads = 0);
+
+  /**
+   * @brief Stop and join the workers
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * @brief Get the number of threads working on a loop, including the caller
+   * @return Number of threads
+   */
+  size_t size() const;
+
+  /**
+   * @brief Run task(i) for every i in [0, count) and wait for all of them.
+   * Indices are handed out in chunks of grain, so no two threads ever run
+   * the same index. Loops shorter than a chunk run inline.
+   * @param count Number of indices
+   * @param task Work for one index; must be safe to run concurrently
+   * @param grain Indices a thread claims at once
+   */
+  void parallelFor(size_t count, const std::function<void(size_t)>& task,
+                   size_t grain = 32);
+
+ private:
+  /**
+   * @brief Body of a worker: help with every loop until stopped
+   */
+  void run();
+
+  /**
+   * @brief Claim and run chunks of the current loop until none are left
+   */
+  void work();
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable loopStarted;
+  std::condition_variable loopFinished;
+  bool stopping = false;
+  // bumped for every loop so workers can tell a new loop from a spurious
+  // wakeup
+  unsigned long generation = 0;
+  // workers still busy with the current loop
+  size_t busy = 0;
+
+  const std::function<void(size_t)>* task = nullptr;
+  size_t count = 0;
+  size_t grain = 1;
+  std::atomic<size_t> next{0};
+};
+
+#endif  // THREAD_POOL_H_
@@ -0,0 +1,84 @@
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include <functional>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @class TimerWheel
+ * @brief Hierarchical timer wheel that runs callbacks at future simulation
+ * times.
+ *
+ * Time is cut into ticks of a fixed resolution. Each level of the wheel has
+ * 64 slots, and a slot on level n spans 64^n ticks. A timer goes into the
+ * coarsest level its deadline still fits in, and moves down a level each
+ * time the wheel reaches its slot, so scheduling, cancelling and advancing a
+ * tick all take constant time no matter how many timers are pending.
+ */
+class TimerWheel {
+ public:
+  /// Identifies a scheduled timer, never zero
+  using Handle = unsigned long;
+
+  /**
+   * @brief Constructor
+   * @param resolution Seconds per wheel tick; timers fire on the first tick
+   * at or after their time
+   */
+  explicit TimerWheel(double resolution = 0.01);
+
+  /**
+   * @brief Run a callback at a simulation time
+   * @param time Simulation time in seconds; a time that already passed fires
+   * on the next advance
+   * @param callback Runs from advance()
+   * @return Handle to cancel the timer with
+   */
+  Handle schedule(double time, std::function<void()> callback);
+
+  /**
+   * @brief Drop a pending timer, does nothing if it already fired
+   * @param handle Timer to drop
+   */
+  void cancel(Handle handle);
+
+  /**
+   * @brief Move the wheel forward and run the timers that came due, in the
+   * order of their times and, for equal times, the order they were scheduled
+   * @param time Simulation time in seconds
+   */
+  void advance(double time);
+
+  /**
+   * @brief Get the number of pending timers
+   * @return Timers that have neither fired nor been cancelled
+   */
+  size_t size() const;
+
+ private:
+  struct Timer {
+    Handle handle;
+    long due;
+    std::function<void()> callback;
+  };
+
+  static constexpr int levels = 4;
+  static constexpr int slotBits = 6;
+  static constexpr long slots = 1L << slotBits;
+
+  void insert(Timer timer);
+  void step();
+
+  double resolution;
+  long now = 0;
+  Handle nextHandle = 1;
+  std::vector<Timer> wheel[levels][slots];
+  // timers further out than the wheel spans
+  std::vector<Timer> overflow;
+  std::unordered_set<Handle> pending;
+  // timers in the wheel, including cancelled ones not dropped yet
+  size_t stored = 0;
+};
+
+#endif  // TIMER_WHEEL_H_
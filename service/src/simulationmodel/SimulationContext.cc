@@ -0,0 +1,51 @@
+#include "SimulationContext.h"
+
+#include <stdexcept>
+
+thread_local SimulationContext* SimulationContext::bound = nullptr;
+
+SimulationContext::Scope::Scope(SimulationContext& context)
+    : previous(bound) {
+  bound = &context;
+}
+
+SimulationContext::Scope::~Scope() { bound = previous; }
+
+SimulationContext::SimulationContext(unsigned seed)
+    : atc(dataCollection, store), seed(seed) {}
+
+SimulationContext& SimulationContext::current() {
+  if (!bound) {
+    throw std::logic_error("No simulation context bound to this thread");
+  }
+  return *bound;
+}
+
+int SimulationContext::nextId() {
+  // only uniqueness matters, so no ordering with other memory is needed
+  return ids.fetch_add(1, std::memory_order_relaxed);
+}
+
+int SimulationContext::peekNextId() const {
+  return ids.load(std::memory_order_relaxed);
+}
+
+void SimulationContext::setNextId(int id) {
+  ids.store(id, std::memory_order_relaxed);
+}
+
+EntityStore& SimulationContext::getStore() { return store; }
+
+EntityRegistry& SimulationContext::getEntities() { return entities; }
+
+StrategyPool& SimulationContext::getStrategies() { return strategies; }
+
+ATC& SimulationContext::getATC() { return atc; }
+
+DataCollectionManager& SimulationContext::getDataCollection() {
+  return dataCollection;
+}
+
+unsigned SimulationContext::getSeed() const { return seed; }
+
+void SimulationContext::setSeed(unsigned seed) { this->seed = seed; }
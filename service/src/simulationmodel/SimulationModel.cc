@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cstdlib>
 #include <iostream>
+#include <stdexcept>
 #include <string>
 
 #include "ATC.h"
@@ -14,30 +15,41 @@
 #include "HelperDrone.h"
 #include "HumanFactory.h"
 #include "LeaderDrone.h"
+#include "Log.h"
 #include "NoRushShipping.h"
 #include "PackageFactory.h"
 #include "PriorityShipping.h"
 #include "RobotFactory.h"
+#include "Snapshot.h"
 #include "StandardShipping.h"
 
-SimulationModel::SimulationModel(IController &controller)
-    : controller(controller) {
+namespace {
+// below this many awake entities the update runs inline, so tiles would only
+// cost the sorting
+constexpr size_t tileThreshold = 32;
+}  // namespace
+
+SimulationModel::SimulationModel(IController &controller, unsigned seed)
+    : context(seed),
+      controller(controller),
+      entities(context.getEntities()) {
   entityFactory.addFactory(new DroneFactory());
   entityFactory.addFactory(new PackageFactory());
   entityFactory.addFactory(new RobotFactory());
   entityFactory.addFactory(new HumanFactory());
   entityFactory.addFactory(new HelicopterFactory());
   entityFactory.addFactory(new AirplaneFactory());
-  ATC::getInstance().addObserver(this);
+  context.getATC().addObserver(this);
 
-  DataCollectionManager *dcm_instance = DataCollectionManager::getInstance();
+  DataCollectionManager *dcm_instance = &context.getDataCollection();
   dcm_instance->addObserver(this);
 }
 
 SimulationModel::~SimulationModel() {
   // Delete dynamically allocated variables
-  for (auto &[id, entity] : entities) {
-    DataCollectionManager *dcm_instance = DataCollectionManager::getInstance();
+  for (IEntity *entity : entities) {
+    context.getATC().removeEntity(entity->getId());
+    DataCollectionManager *dcm_instance = &context.getDataCollection();
     dcm_instance->removeEntity(entity);
 
     delete entity;
@@ -48,13 +60,36 @@ SimulationModel::~SimulationModel() {
 IEntity *SimulationModel::createEntity(const JsonObject &entity) {
   std::string name = entity["name"];
   JsonArray position = entity["position"];
-  std::cout << name << ": " << position << std::endl;
+  LOG_INFO(name << ": " << position);
+
+  // the new entity and its decorators join this model's context
+  SimulationContext::Scope scope(context);
+  IEntity *myNewEntity = spawn(entity, true);
+  if (myNewEntity) controller.addEntity(*myNewEntity);
+  return myNewEntity;
+}
 
-  IEntity *myNewEntity = nullptr;
-  if (myNewEntity = entityFactory.createEntity(entity)) {
+std::vector<IEntity *> SimulationModel::createEntities(
+    const JsonArray &details) {
+  // one line for the batch instead of a few per entity
+  SimulationContext::Scope scope(context);
+  std::vector<IEntity *> created;
+  created.reserve(details.size());
+  for (int i = 0; i < details.size(); i++) {
+    if (IEntity *entity = spawn(details[i], false)) created.push_back(entity);
+  }
+  LOG_INFO("Created " << created.size() << " of " << details.size()
+                       << " entities");
+  controller.addEntities(created);
+  return created;
+}
+
+IEntity *SimulationModel::spawn(const JsonObject &entity, bool verbose) {
+  IEntity *myNewEntity = entityFactory.createEntity(entity);
+  if (myNewEntity) {
     myNewEntity->linkModel(this);
-    controller.addEntity(*myNewEntity);
-    entities[myNewEntity->getId()] = myNewEntity;
+    entities.add(myNewEntity);
+    awake[myNewEntity->getId()] = myNewEntity;
     myNewEntity->addObserver(this);
 
     // dcm integration
@@ -62,8 +97,8 @@ IEntity *SimulationModel::createEntity(const JsonObject &entity) {
     if (dynamic_cast<Drone *>(myNewEntity) ||
         dynamic_cast<Helicopter *>(myNewEntity) ||
         dynamic_cast<Airplane *>(myNewEntity)) {
-      std::cout << "Adding entity to ATC" << std::endl;
-      ATC::getInstance().addEntity(myNewEntity);
+      if (verbose) LOG_DEBUG("Adding entity to ATC");
+      context.getATC().addEntity(myNewEntity);
     }
 
     // For helper drones, connect them to leader drones
@@ -90,24 +125,11 @@ IEntity *SimulationModel::createEntity(const JsonObject &entity) {
 
           if (helperDrone) {
             // Connect to all leader drones
-            for (auto const &[id, entityPtr] : entities) {
-              if (entityPtr != myNewEntity && entityPtr) {
-                // peel the ATC and Color decorator for the leader drone
-                if (DroneATCDecorator *leaderATCDecorator =
-                        dynamic_cast<DroneATCDecorator *>(entityPtr)) {
-                  // First peel off ATC decorator
-                  DroneColorDecorator *leaderColorDecorator =
-                      dynamic_cast<DroneColorDecorator *>(
-                          leaderATCDecorator->getDecoratedEntity());
-                  if (leaderColorDecorator) {
-                    // peel off color decorator to get the base leader drone
-                    LeaderDrone *leaderDrone = dynamic_cast<LeaderDrone *>(
-                        leaderColorDecorator->getDecoratedEntity());
-                    if (leaderDrone) {
-                      leaderDrone->addHelperDroneObserver(helperDrone);
-                    }
-                  }
-                }
+            for (int id : entities.ofType("leader_drone")) {
+              // getDrone peels the ATC and color decorators
+              if (LeaderDrone *leaderDrone =
+                      dynamic_cast<LeaderDrone *>(getDrone(id))) {
+                leaderDrone->addHelperDroneObserver(helperDrone);
               }
             }
           }
@@ -117,10 +139,11 @@ IEntity *SimulationModel::createEntity(const JsonObject &entity) {
   }
 
   if (myNewEntity) {
-    DataCollectionManager *dcm_instance = DataCollectionManager::getInstance();
+    DataCollectionManager *dcm_instance = &context.getDataCollection();
     dcm_instance->createLog(myNewEntity);
-    std::cout << "Created log for entity pointer: " << myNewEntity->getName()
-              << std::endl;
+    if (verbose) {
+      LOG_DEBUG("Created log for entity pointer: " << myNewEntity->getName());
+    }
   }
   return myNewEntity;
 }
@@ -212,29 +235,25 @@ void SimulationModel::scheduleTrip(const JsonObject &details,
   std::string name = details["name"];
   JsonArray start = details["start"];
   JsonArray end = details["end"];
-  std::cout << name << ": " << start << " --> " << end << " [" << priority
-            << "]" << std::endl;
+  LOG_INFO(name << ": " << start << " --> " << end << " [" << priority
+                << "]");
 
   Robot *receiver = nullptr;
-  for (auto &[id, entity] : entities) {
-    if (name == entity->getName()) {
-      if (Robot *r = dynamic_cast<Robot *>(entity)) {
-        if (r->requestedDelivery) {
-          receiver = r;
-          break;
-        }
+  for (int id : entities.named(name)) {
+    if (Robot *r = dynamic_cast<Robot *>(entities.get(id))) {
+      if (r->requestedDelivery) {
+        receiver = r;
+        break;
       }
     }
   }
 
   Package *package = nullptr;
-  for (auto &[id, entity] : entities) {
-    if (name + "_package" == entity->getName()) {
-      if (Package *p = dynamic_cast<Package *>(entity)) {
-        if (p->requiresDelivery()) {
-          package = p;
-          break;
-        }
+  for (int id : entities.named(name + "_package")) {
+    if (Package *p = dynamic_cast<Package *>(entities.get(id))) {
+      if (p->requiresDelivery()) {
+        package = p;
+        break;
       }
     }
   }
@@ -248,8 +267,7 @@ void SimulationModel::scheduleTrip(const JsonObject &details,
       } else if (priority == "Expedited") {
         package->setPriority(new ExpeditedShipping());
       } else {
-        std::cout << "Unknown priority type. Defaulting to Standard."
-                  << std::endl;
+        LOG_WARNING("Unknown priority type. Defaulting to Standard.");
         package->setPriority(new StandardShipping());
       }
     }
@@ -261,19 +279,37 @@ void SimulationModel::scheduleTrip(const JsonObject &details,
     package->setStrategyName(strategyName);
     scheduledDeliveries.push_back(package);
     sortScheduledDeliveries();
+    wakeAwaitingDelivery();
     controller.sendEventToView("DeliveryScheduled", details);
   }
 }
 
 void SimulationModel::sortScheduledDeliveries() {
+  dropRemovedDeliveries();
   std::sort(scheduledDeliveries.begin(), scheduledDeliveries.end(),
             [](Package *a, Package *b) {
               return a->getPriorityLevel() < b->getPriorityLevel();
             });
 }
 
+Package *SimulationModel::takeDelivery() {
+  while (!scheduledDeliveries.empty()) {
+    Package *package = scheduledDeliveries.front();
+    scheduledDeliveries.pop_front();
+    if (package) return package;
+  }
+  return nullptr;
+}
+
+void SimulationModel::dropRemovedDeliveries() {
+  std::erase_if(scheduledDeliveries,
+                [](const EntityRef<Package> &package) { return !package; });
+}
+
 const routing::Graph *SimulationModel::getGraph() const { return graph; }
 
+SimulationContext &SimulationModel::getContext() { return context; }
+
 void SimulationModel::setGraph(const routing::Graph *graph) {
   if (this->graph) delete this->graph;
   this->graph = graph;
@@ -281,77 +317,331 @@ void SimulationModel::setGraph(const routing::Graph *graph) {
 
 /// Updates the simulation
 void SimulationModel::update(double dt) {
-  for (auto &[id, entity] : entities) {
-    entity->update(dt);
-    controller.updateEntity(*entity);
+  // reroutes and logs decided on the last snapshot
+  context.getATC().applyCommands();
+  // wake the entities whose alarm goes off during this tick
+  timers.advance(time + dt);
+  ++ticks;
+  time += dt;
+
+  // step every path follower along its stretch in one pass; the strategies
+  // pick up the results during the update
+  context.getStore().walkPaths(dt);
+
+  // only awake entities are updated and sent to the view
+  updateOrder.clear();
+  for (auto &[id, entity] : awake) updateOrder.push_back(entity);
+  if (effects.size() < updateOrder.size()) effects.resize(updateOrder.size());
+
+  // compute: every entity advances its own state against the world as it
+  // was at the start of the tick
+  auto compute = [this, dt](size_t i) {
+    IEntity::deferEffects(&effects[i]);
+    updateOrder[i]->update(dt);
+    IEntity::deferEffects(nullptr);
+  };
+  if (tiles.isEnabled() && workers.size() > 1 &&
+      updateOrder.size() > tileThreshold) {
+    // a thread claims a whole tile, so neighbours are updated together and
+    // threads write to separate runs of store rows
+    assignTiles();
+    workers.parallelFor(
+        tiles.size(),
+        [this, &compute](size_t tile) {
+          for (const size_t *i = tiles.begin(tile); i != tiles.end(tile); ++i) {
+            compute(*i);
+          }
+        },
+        1);
+  } else {
+    workers.parallelFor(updateOrder.size(), compute);
+  }
+
+  // commit: apply pickups, queue pops and handoffs in entity order, so the
+  // outcome does not depend on how the work was split
+  for (size_t i = 0; i < updateOrder.size(); ++i) {
+    for (std::function<void()> &effect : effects[i]) effect();
+    effects[i].clear();
   }
+  context.getStore().followCarriers();
+  for (IEntity *entity : updateOrder) controller.updateEntity(*entity);
 
   for (int id : removed) {
     removeFromSim(id);
   }
   removed.clear();
-  ATC::getInstance().update(dt);
+  context.getATC().update(dt);
+}
+
+void SimulationModel::assignTiles() {
+  updateIds.clear();
+  for (IEntity *entity : updateOrder) updateIds.push_back(entity->getId());
+  EntityStore &store = context.getStore();
+  if (!tiles.assign(updateIds, store)) return;
+  // entities that joined, left or crossed into another tile move their rows
+  // next to the rest of their tile
+  tiledIds.clear();
+  for (size_t tile = 0; tile < tiles.size(); ++tile) {
+    for (const size_t *i = tiles.begin(tile); i != tiles.end(tile); ++i) {
+      tiledIds.push_back(updateIds[*i]);
+    }
+  }
+  store.arrange(tiledIds);
+}
+
+void SimulationModel::setTileSize(double size) { tiles.setSize(size); }
+
+const SpatialTiles &SimulationModel::getTiles() const { return tiles; }
+
+void SimulationModel::setRetireDelivered(bool retire) {
+  retireDelivered = retire;
 }
 
+bool SimulationModel::getRetireDelivered() const { return retireDelivered; }
+
 void SimulationModel::stop(void) {}
 
+void SimulationModel::sleepEntity(int id, double until) {
+  if (!awake.erase(id)) return;
+  Sleeper &sleeper = sleeping[id] = {ticks, time, until};
+  if (until < std::numeric_limits<double>::infinity()) {
+    sleeper.alarm = timers.schedule(until, [this, id] { wakeEntity(id); });
+  }
+}
+
+void SimulationModel::wakeEntity(int id) {
+  auto it = sleeping.find(id);
+  if (it == sleeping.end()) return;
+  Sleeper &sleeper = it->second;
+  if (sleeper.alarm) timers.cancel(sleeper.alarm);
+  IEntity *entity = entities.get(id);
+  entity->fastForward(time - sleeper.time, ticks - sleeper.tick);
+  // the entity still counts the ticks it slept through
+  context.getDataCollection().logEvent(entity, "timesteps_of_entity",
+                                       ticks - sleeper.tick);
+  sleeping.erase(it);
+  awaitingDelivery.erase(id);
+  awake[id] = entity;
+}
+
+bool SimulationModel::isAsleep(int id) const { return sleeping.count(id); }
+
+void SimulationModel::awaitDelivery(int id, double until) {
+  if (until <= time) return;
+  sleepEntity(id, until);
+  if (sleeping.count(id)) awaitingDelivery.insert(id);
+}
+
+void SimulationModel::packageDelivered(Package *package) {
+  if (!retireDelivered) return;
+  removeEntity(package->getId());
+  if (Robot *owner = package->getOwner()) removeEntity(owner->getId());
+}
+
+void SimulationModel::wakeAwaitingDelivery() {
+  std::set<int> waiting;
+  waiting.swap(awaitingDelivery);
+  for (int id : waiting) wakeEntity(id);
+}
+
+double SimulationModel::getTime() const { return time; }
+
+long SimulationModel::getTicks() const { return ticks; }
+
+void SimulationModel::logSleepingTime() {
+  for (auto &[id, sleeper] : sleeping) {
+    IEntity *entity = entities.get(id);
+    entity->fastForward(time - sleeper.time, ticks - sleeper.tick);
+    context.getDataCollection().logEvent(entity, "timesteps_of_entity",
+                                         ticks - sleeper.tick);
+    sleeper.tick = ticks;
+    sleeper.time = time;
+  }
+}
+
+IEntity *SimulationModel::getEntity(int id) const { return entities.get(id); }
+
+Drone *SimulationModel::getDrone(int id) const {
+  // peel off the ATC and color decorators
+  auto *atcDecorator = dynamic_cast<DroneATCDecorator *>(getEntity(id));
+  if (!atcDecorator) return nullptr;
+  auto *colorDecorator =
+      dynamic_cast<DroneColorDecorator *>(atcDecorator->getDecoratedEntity());
+  return colorDecorator ? colorDecorator->getDecoratedEntity() : nullptr;
+}
+
+void SimulationModel::save(std::ostream &stream) {
+  // let the ATC thread finish with every snapshot and apply what it
+  // decided, so neither its state nor its commands change while we write
+  context.getATC().quiesce();
+
+  SnapshotWriter out(stream);
+  out.write(context.getSeed());
+  out.write(context.peekNextId());
+  out.write(ticks);
+  out.write(time);
+
+  // all entities are recreated before any state is read, so references
+  // between entities can be resolved by id
+  out.write(static_cast<std::uint64_t>(entities.size()));
+  for (IEntity *entity : entities) {
+    out.write(entity->getId());
+    out.write(entity->getDetails().toString());
+  }
+  for (IEntity *entity : entities) entity->save(out);
+
+  dropRemovedDeliveries();
+  out.write(static_cast<std::uint64_t>(scheduledDeliveries.size()));
+  for (Package *package : scheduledDeliveries) out.write(package->getId());
+
+  // sleepers in the order their alarms were set, so alarms due on the same
+  // tick still go off in the same order
+  std::vector<std::pair<int, Sleeper>> sleepers(sleeping.begin(),
+                                                sleeping.end());
+  std::sort(sleepers.begin(), sleepers.end(), [](const auto &a, const auto &b) {
+    return std::tie(a.second.alarm, a.first) <
+           std::tie(b.second.alarm, b.first);
+  });
+  out.write(static_cast<std::uint64_t>(sleepers.size()));
+  for (auto &[id, sleeper] : sleepers) {
+    out.write(id);
+    out.write(sleeper.tick);
+    out.write(sleeper.time);
+    out.write(sleeper.until);
+  }
+  out.write(static_cast<std::uint64_t>(awaitingDelivery.size()));
+  for (int id : awaitingDelivery) out.write(id);
+  out.write(static_cast<std::uint64_t>(removed.size()));
+  for (int id : removed) out.write(id);
+
+  context.getATC().save(out);
+  context.getDataCollection().save(out);
+  if (!out.good()) throw std::runtime_error("Cannot write snapshot");
+}
+
+void SimulationModel::restore(std::istream &stream) {
+  if (!entities.empty()) {
+    throw std::logic_error("Snapshots restore into a model without entities");
+  }
+  SnapshotReader in(stream);
+  context.setSeed(in.read<unsigned>());
+  int nextId = in.read<int>();
+  ticks = in.read<long>();
+  time = in.read<double>();
+
+  std::vector<IEntity *> restored;
+  std::uint64_t count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    int id = in.read<int>();
+    picojson::value details;
+    std::string error = picojson::parse(details, in.readString());
+    if (!error.empty() || !details.is<picojson::object>()) {
+      throw std::runtime_error("Snapshot has bad details for entity " +
+                               std::to_string(id));
+    }
+    // the entity and its decorators get the ids they were saved with
+    context.setNextId(id);
+    IEntity *entity = createEntity(details.get<picojson::object>());
+    if (!entity || entity->getId() != id) {
+      throw std::runtime_error("Cannot recreate entity " + std::to_string(id));
+    }
+    restored.push_back(entity);
+  }
+  context.setNextId(nextId);
+  for (IEntity *entity : restored) entity->load(in);
+
+  count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    Package *package = dynamic_cast<Package *>(getEntity(in.read<int>()));
+    if (package) scheduledDeliveries.push_back(package);
+  }
+
+  // with no alarm pending the wheel jumps straight to the current time
+  timers.advance(time);
+  count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    int id = in.read<int>();
+    Sleeper sleeper;
+    sleeper.tick = in.read<long>();
+    sleeper.time = in.read<double>();
+    sleeper.until = in.read<double>();
+    if (sleeper.until < std::numeric_limits<double>::infinity()) {
+      sleeper.alarm =
+          timers.schedule(sleeper.until, [this, id] { wakeEntity(id); });
+    }
+    awake.erase(id);
+    sleeping[id] = sleeper;
+  }
+  count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    awaitingDelivery.insert(in.read<int>());
+  }
+  count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) removed.insert(in.read<int>());
+
+  context.getATC().load(in);
+  context.getDataCollection().load(in);
+}
+
 void SimulationModel::removeFromSim(int id) {
-  IEntity *entity = entities[id];
+  IEntity *entity = entities.get(id);
   if (entity) {
-    for (auto i = scheduledDeliveries.begin(); i != scheduledDeliveries.end();
-         ++i) {
-      if (*i == entity) {
-        scheduledDeliveries.erase(i);
-        break;
-      }
-    }
+    // stop tracking the entity before it is freed
+    context.getATC().removeEntity(id);
+
     // DCM
-    DataCollectionManager *dcm_instance = DataCollectionManager::getInstance();
+    DataCollectionManager *dcm_instance = &context.getDataCollection();
     dcm_instance->removeEntity(entity);
 
     controller.removeEntity(*entity);
-    entities.erase(id);
+    // references to the entity and its queued delivery go stale with it
+    entities.remove(id);
+    awake.erase(id);
+    auto sleeper = sleeping.find(id);
+    if (sleeper != sleeping.end()) {
+      if (sleeper->second.alarm) timers.cancel(sleeper->second.alarm);
+      sleeping.erase(sleeper);
+    }
+    awaitingDelivery.erase(id);
     delete entity;
   }
 }
 
 bool SimulationModel::changePackagePriority(const std::string &packageName,
                                             const std::string &priority) {
-  for (auto &[id, entity] : entities) {
-    if (entity->getName() == packageName) {
-      if (Package *package = dynamic_cast<Package *>(entity)) {
-        if (!package->isScheduled()) {
-          std::cout << "Too late to change priority of package" << std::endl;
-          return false;
-        }
+  for (int id : entities.named(packageName)) {
+    if (Package *package = dynamic_cast<Package *>(entities.get(id))) {
+      if (!package->isScheduled()) {
+        LOG_INFO("Too late to change priority of package");
+        return false;
+      }
 
-        if (priority == "Standard" && !package->getPackagePickedUp()) {
-          std::cout << "package is set to standard" << std::endl;
-          package->setPriority(new StandardShipping());
-          std::cout << package->getName() << " new priority is "
-                    << package->getPriorityName() << std::endl;
-        }
+      if (priority == "Standard" && !package->getPackagePickedUp()) {
+        LOG_DEBUG("package is set to standard");
+        package->setPriority(new StandardShipping());
+        LOG_INFO(package->getName() << " new priority is "
+                                    << package->getPriorityName());
+      }
 
-        else if (priority == "NoRush" && !package->getPackagePickedUp()) {
-          std::cout << "package is set to norush" << std::endl;
+      else if (priority == "NoRush" && !package->getPackagePickedUp()) {
+        LOG_DEBUG("package is set to norush");
 
-          package->setPriority(new NoRushShipping());
-          std::cout << package->getName() << " new priority is "
-                    << package->getPriorityName() << std::endl;
-        }
+        package->setPriority(new NoRushShipping());
+        LOG_INFO(package->getName() << " new priority is "
+                                    << package->getPriorityName());
+      }
 
-        else if (priority == "Expedited" && !package->getPackagePickedUp()) {
-          std::cout << "package is set to expedited" << std::endl;
+      else if (priority == "Expedited" && !package->getPackagePickedUp()) {
+        LOG_DEBUG("package is set to expedited");
 
-          package->setPriority(new ExpeditedShipping());
-          std::cout << package->getName() << " new priority is "
-                    << package->getPriorityName() << std::endl;
-        } else {
-          return false;
-        }
-        sortScheduledDeliveries();
-        return true;
+        package->setPriority(new ExpeditedShipping());
+        LOG_INFO(package->getName() << " new priority is "
+                                    << package->getPriorityName());
+      } else {
+        return false;
       }
+      sortScheduledDeliveries();
+      return true;
     }
   }
   return false;
@@ -362,6 +652,7 @@ JsonObject SimulationModel::getDeliveryQueueInfo() const {
   JsonArray queueArray;
 
   for (const Package *pkg : scheduledDeliveries) {
+    if (!pkg) continue;
     JsonObject pkgInfo;
     pkgInfo["name"] = pkg->getName();
     pkgInfo["priority"] = pkg->getPriorityName();
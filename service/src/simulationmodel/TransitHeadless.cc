@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <chrono>  // NOLINT [build/c++11]
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "ATC.h"
+#include "CommandLog.h"
+#include "DataCollectionManager.h"
+#include "Log.h"
+#include "OBJParser.h"
+#include "SimulationModel.h"
+#include "picojson.h"
+
+//--------------------  Headless Controller ----------------------------
+
+/// Controller without a view. Nothing is sent anywhere; it only counts the
+/// deliveries the model reports.
+class HeadlessController : public IController {
+ public:
+  void addEntity(const IEntity & /*entity*/) {}
+
+  void updateEntity(const IEntity & /*entity*/) {}
+
+  void removeEntity(const IEntity & /*entity*/) {}
+
+  void sendEventToView(const std::string &event, const JsonObject &details) {
+    if (event != "Notification") return;
+    std::string message = details["message"];
+    if (message.find(" dropped off: ") != std::string::npos) ++deliveries;
+  }
+
+  int deliveries = 0;
+};
+
+/// Options of a batch run
+struct HeadlessOptions {
+  std::string scene = "web/public/scenes/umn.json";
+  double simTime = 600;
+  double step = 0.01;
+  int trips = 10;
+  double tripInterval = 0;
+  unsigned seed = 1;
+  bool syncATC = false;
+  // remove delivered packages and their robots
+  bool retireDelivered = false;
+  // command log to replay instead of running the scene
+  std::string replay;
+  // snapshot to write at the end, and every checkpoint seconds if positive
+  std::string snapshot;
+  double checkpoint = 0;
+  // snapshot to continue from instead of the scene's entities
+  std::string restore;
+  // edge of the tiles of the parallel update, negative keeps the default
+  double tileSize = -1;
+  LogLevel logLevel = LogLevel::Info;
+};
+
+/// Runs a command the way the transit service does. Commands that only
+/// matter to the view are ignored.
+void runCommand(SimulationModel &model, const std::string &name,
+                const JsonObject &params) {
+  if (name == "SetGraph") {
+    std::string graph = params["filePath"];
+    model.setGraph(routing::OBJGraphParser(graph));
+  } else if (name == "CreateEntity") {
+    model.createEntity(params);
+  } else if (name == "CreateEntities") {
+    model.createEntities(params["entities"]);
+  } else if (name == "ScheduleTrip") {
+    std::string priority = "Standard";
+    if (params.contains("priority")) {
+      priority = std::string(params["priority"]);
+    }
+    model.scheduleTrip(params, priority);
+  } else if (name == "ChangePriority") {
+    std::string packageName = params["packageName"];
+    std::string priority = params["priority"];
+    model.changePackagePriority(packageName, priority);
+  } else if (name == "writeStats") {
+    model.logSleepingTime();
+    model.getContext().getDataCollection().exportLog();
+  } else if (name == "stopSimulation") {
+    model.stop();
+  }
+}
+
+/// Runs the commands of a scene file that build the simulation. Runs of
+/// CreateEntity commands go to the model as one batch, like the web client
+/// sends them. With graphOnly only the graph is set, for continuing from a
+/// snapshot that already holds the entities.
+bool loadScene(SimulationModel &model, const std::string &path,
+               bool graphOnly = false) {
+  std::ifstream file(path);
+  if (!file) {
+    std::cerr << "Cannot open scene " << path << std::endl;
+    return false;
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  picojson::value scene;
+  std::string error = picojson::parse(scene, contents.str());
+  if (!error.empty() || !scene.is<picojson::array>()) {
+    std::cerr << "Cannot parse scene " << path << ": " << error << std::endl;
+    return false;
+  }
+
+  JsonArray commands(scene.get<picojson::array>());
+  JsonArray batch;
+  for (int i = 0; i < commands.size(); i++) {
+    JsonObject command = commands[i];
+    std::string name = command["command"];
+    JsonObject params = command["params"];
+    if (graphOnly && name != "SetGraph") continue;
+    if (name == "CreateEntity") {
+      batch.push(params);
+      continue;
+    }
+    if (batch.size() > 0) {
+      model.createEntities(batch);
+      batch = JsonArray();
+    }
+    runCommand(model, name, params);
+  }
+  if (batch.size() > 0) model.createEntities(batch);
+  return true;
+}
+
+/// Replays a command log recorded by the transit service: every command runs
+/// at the tick it ran at in the recorded session, with the session's seed
+/// and step, so the run repeats the session exactly. Returns the number of
+/// ticks run, or -1 if the log cannot be read.
+long replayLog(HeadlessController &controller, const std::string &path) {
+  CommandReader log(path);
+  if (!log.isOpen()) {
+    std::cerr << "Cannot read command log " << path << std::endl;
+    return -1;
+  }
+  const CommandLogHeader &header = log.getHeader();
+  SimulationModel model(controller, header.seed);
+  if (header.syncATC) model.getContext().getATC().setThreaded(false);
+  model.setRetireDelivered(header.retireDelivered);
+
+  CommandLogEntry entry;
+  while (log.next(entry)) {
+    while (model.getTicks() < entry.tick) model.update(header.step);
+    if (entry.command == "Update") continue;
+    try {
+      runCommand(model, entry.command, entry.params);
+    } catch (const std::exception &e) {
+      // the live service reported the same error and carried on
+      std::cerr << "Error handling command " << entry.command << ": "
+                << e.what() << std::endl;
+    }
+  }
+  return model.getTicks();
+}
+
+/// Writes a snapshot of the model. It goes to a temporary file first, so a
+/// crash while writing leaves the previous snapshot intact.
+bool saveSnapshot(SimulationModel &model, const std::string &path) {
+  std::string partial = path + ".tmp";
+  try {
+    std::ofstream file(partial, std::ios::binary);
+    model.save(file);
+    file.close();
+    if (!file) throw std::runtime_error("cannot write " + partial);
+  } catch (const std::exception &e) {
+    std::cerr << "Cannot save snapshot " << path << ": " << e.what()
+              << std::endl;
+    return false;
+  }
+  if (std::rename(partial.c_str(), path.c_str()) != 0) {
+    std::cerr << "Cannot replace snapshot " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/// Creates a package and its receiving robot the way the web client does,
+/// then schedules the trip between them
+void scheduleTrip(SimulationModel &model, std::mt19937 &random, int number) {
+  std::uniform_real_distribution<double> x(-1400, 1500);
+  std::uniform_real_distribution<double> z(-800, 800);
+  const double ground = 254.665;
+  JsonArray start = {x(random), ground, z(random)};
+  JsonArray end = {x(random), ground, z(random)};
+  std::string name = "Trip" + std::to_string(number);
+
+  JsonObject package;
+  package["type"] = "package";
+  package["name"] = name + "_package";
+  package["position"] = start;
+  package["direction"] = JsonArray({1.0, 0.0, 0.0});
+  package["speed"] = 30.0;
+  model.createEntity(package);
+
+  JsonObject robot;
+  robot["type"] = "robot";
+  robot["name"] = name;
+  robot["position"] = end;
+  robot["direction"] = JsonArray({1.0, 0.0, 0.0});
+  robot["speed"] = 30.0;
+  model.createEntity(robot);
+
+  JsonObject trip;
+  trip["name"] = name;
+  trip["start"] = start;
+  trip["end"] = end;
+  trip["search"] = "astar";
+  model.scheduleTrip(trip, "Standard");
+}
+
+/// Reads the command line, returns false on a bad argument
+bool parseOptions(int argc, char **argv, HeadlessOptions &options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--time" && hasValue) {
+      options.simTime = std::atof(argv[++i]);
+    } else if (arg == "--step" && hasValue) {
+      options.step = std::atof(argv[++i]);
+    } else if (arg == "--trips" && hasValue) {
+      options.trips = std::atoi(argv[++i]);
+    } else if (arg == "--trip-interval" && hasValue) {
+      options.tripInterval = std::atof(argv[++i]);
+    } else if (arg == "--seed" && hasValue) {
+      options.seed = std::atoi(argv[++i]);
+    } else if (arg == "--sync-atc") {
+      options.syncATC = true;
+    } else if (arg == "--retire-delivered") {
+      options.retireDelivered = true;
+    } else if (arg == "--replay" && hasValue) {
+      options.replay = argv[++i];
+    } else if (arg == "--snapshot" && hasValue) {
+      options.snapshot = argv[++i];
+    } else if (arg == "--checkpoint" && hasValue) {
+      options.checkpoint = std::atof(argv[++i]);
+    } else if (arg == "--restore" && hasValue) {
+      options.restore = argv[++i];
+    } else if (arg == "--tile-size" && hasValue) {
+      options.tileSize = std::atof(argv[++i]);
+    } else if (arg == "--log-level" && hasValue) {
+      if (!Log::parseLevel(argv[++i], options.logLevel)) return false;
+    } else if (arg[0] != '-') {
+      options.scene = arg;
+    } else {
+      return false;
+    }
+  }
+  return options.simTime > 0 && options.step > 0;
+}
+
+/// Runs a scene as fast as possible and reports the throughput
+int main(int argc, char **argv) {
+  HeadlessOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    std::cout << "Usage: ./build/bin/transit_headless [scene.json] "
+                 "[--time seconds] [--step seconds] [--trips n] "
+                 "[--trip-interval seconds] [--seed n] [--sync-atc] "
+                 "[--replay log.jsonl] [--snapshot file] "
+                 "[--checkpoint seconds] [--restore file] "
+                 "[--tile-size meters] [--retire-delivered] "
+                 "[--log-level level]"
+              << std::endl;
+    return 1;
+  }
+
+  Log::setLevel(options.logLevel);
+
+  HeadlessController controller;
+  if (!options.replay.empty()) {
+    auto start = std::chrono::steady_clock::now();
+    long ticks = replayLog(controller, options.replay);
+    if (ticks < 0) return 1;
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    // the report comes after everything the run logged
+    Log::flush();
+    std::cout << "replayed:          " << options.replay << std::endl;
+    std::cout << "ticks:             " << ticks << std::endl;
+    std::cout << "wall time:         " << elapsed.count() << " s"
+              << std::endl;
+    std::cout << "deliveries:        " << controller.deliveries << std::endl;
+    return 0;
+  }
+
+  SimulationModel model(controller, options.seed);
+  // evaluating on the simulation thread makes runs reproducible
+  if (options.syncATC) model.getContext().getATC().setThreaded(false);
+  if (options.tileSize >= 0) model.setTileSize(options.tileSize);
+  model.setRetireDelivered(options.retireDelivered);
+  bool restoring = !options.restore.empty();
+  if (!loadScene(model, options.scene, restoring)) return 1;
+  if (restoring) {
+    std::ifstream file(options.restore, std::ios::binary);
+    try {
+      if (!file) throw std::runtime_error("cannot open the file");
+      model.restore(file);
+    } catch (const std::exception &e) {
+      std::cerr << "Cannot restore snapshot " << options.restore << ": "
+                << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  std::mt19937 random(options.seed);
+  int tripsScheduled = 0;
+  // a restored simulation has its trips already
+  for (; !restoring && tripsScheduled < options.trips; tripsScheduled++) {
+    scheduleTrip(model, random, tripsScheduled);
+  }
+
+  long ticks = std::lround(options.simTime / options.step);
+  long ticksPerTrip =
+      options.tripInterval > 0
+          ? std::max(1L, std::lround(options.tripInterval / options.step))
+          : 0;
+  long ticksPerCheckpoint =
+      options.checkpoint > 0 && !options.snapshot.empty()
+          ? std::max(1L, std::lround(options.checkpoint / options.step))
+          : 0;
+  auto start = std::chrono::steady_clock::now();
+  for (long tick = 1; tick <= ticks; tick++) {
+    model.update(options.step);
+    if (ticksPerTrip && tick % ticksPerTrip == 0) {
+      scheduleTrip(model, random, tripsScheduled++);
+    }
+    if (ticksPerCheckpoint && tick % ticksPerCheckpoint == 0) {
+      saveSnapshot(model, options.snapshot);
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  double wall = elapsed.count();
+  double simTime = ticks * options.step;
+
+  if (!options.snapshot.empty() && !saveSnapshot(model, options.snapshot)) {
+    return 1;
+  }
+
+  model.logSleepingTime();
+  model.getContext().getDataCollection().exportLog();
+  Log::flush();
+
+  std::cout << "scene:             " << options.scene << std::endl;
+  std::cout << "sim time:          " << simTime << " s" << std::endl;
+  std::cout << "wall time:         " << wall << " s" << std::endl;
+  std::cout << "trips scheduled:   " << tripsScheduled << std::endl;
+  std::cout << "deliveries:        " << controller.deliveries << std::endl;
+  std::cout << "tile migrations:   " << model.getTiles().getMigrations()
+            << std::endl;
+  std::cout << "entities alive:    " << model.getContext().getEntities().size()
+            << std::endl;
+  if (wall > 0) {
+    std::cout << "sim s / wall s:    " << simTime / wall << std::endl;
+    std::cout << "ticks / s:         " << ticks / wall << std::endl;
+    std::cout << "deliveries / s:    " << controller.deliveries / wall
+              << std::endl;
+  }
+  return 0;
+}
@@ -1,8 +1,14 @@
 #include <chrono>  // NOLINT [build/c++11]
 #include <map>
+#include <memory>
+#include <random>
 #include <string>
+#include <vector>
 
+#include "CommandLog.h"
 #include "DataCollectionManager.h"
+#include "FixedStepClock.h"
+#include "Log.h"
 #include "OBJParser.h"
 #include "Package.h"
 #include "PriorityShipping.h"
@@ -11,13 +17,41 @@
 
 //--------------------  Controller ----------------------------
 bool stopped = false;
+// Prefix of the command logs, empty when sessions are not recorded
+std::string recordPrefix;
+// Whether the ATC evaluates on the simulation thread
+bool syncATC = false;
+// Whether delivered packages and their robots leave the simulation
+bool retireDelivered = false;
+// Sessions started so far, numbers the command logs
+int sessions = 0;
 /// A Transit Service that communicates with a web page through web sockets.  It
 /// also acts as the controller in the model view controller pattern.
 class TransitService : public JsonSession, public IController {
  public:
   TransitService()
-      : model(*this), start(std::chrono::system_clock::now()), time(0.0) {
+      : model(*this, std::random_device()()),
+        start(std::chrono::steady_clock::now()),
+        time(0.0) {
     // Drones are now created in SimulationModel constructor
+    if (syncATC) model.getContext().getATC().setThreaded(false);
+    model.setRetireDelivered(retireDelivered);
+    if (!recordPrefix.empty()) {
+      std::string path =
+          recordPrefix + "_" + std::to_string(sessions++) + ".jsonl";
+      CommandLogHeader header;
+      header.seed = model.getContext().getSeed();
+      header.step = clock.getStep();
+      header.syncATC = syncATC;
+      header.retireDelivered = retireDelivered;
+      recorder = std::make_unique<CommandRecorder>(path, header);
+      if (recorder->isOpen()) {
+        LOG_INFO("Recording commands to " << path);
+      } else {
+        LOG_ERROR("Cannot write command log " << path);
+        recorder.reset();
+      }
+    }
   }
 
   /// Handles specific commands from the web server
@@ -25,8 +59,13 @@ class TransitService : public JsonSession, public IController {
                       JsonObject &returnValue) {
     try {
       // std::cout << cmd << ": " << data << std::endl;
+      if (recorder && CommandRecorder::changesSimulation(cmd)) {
+        recorder->record(model.getTicks(), cmd, data);
+      }
       if (cmd == "CreateEntity") {
         model.createEntity(data);
+      } else if (cmd == "CreateEntities") {
+        model.createEntities(data["entities"]);
       } else if (cmd == "SetGraph") {
         std::string path = data["filePath"];
         model.setGraph(routing::OBJGraphParser(path));
@@ -37,21 +76,21 @@ class TransitService : public JsonSession, public IController {
         }
         model.scheduleTrip(data, priority);
       } else if (cmd == "ChangePriority") {
-        std::cout << "Command received to changePriority" << std::endl;
+        LOG_DEBUG("Command received to changePriority");
         std::string packageName = data["packageName"];
         std::string priority = data["priority"];
-        std::cout << "Attempting to change priority for package: "
-                  << packageName << " to " << priority << std::endl;
+        LOG_INFO("Attempting to change priority for package: "
+                 << packageName << " to " << priority);
         bool success = model.changePackagePriority(packageName, priority);
-        std::cout << data << std::endl;
+        LOG_DEBUG(data);
 
         if (!success) {
-          std::cout << "Priority change failed." << std::endl;
+          LOG_INFO("Priority change failed.");
           // std::cout << "Priority change failed." << std::endl;
           notify("Could not change priority for " + packageName +
                  ". Package may already be picked up already or doesnt exist.");
         } else {
-          std::cout << "Priority change finally working lol." << std::endl;
+          LOG_DEBUG("Priority change finally working lol.");
           // std::cout << "Priority change finally working lol." << std::endl;
 
           notify("Successfully changed the priority status for " + packageName +
@@ -65,39 +104,46 @@ class TransitService : public JsonSession, public IController {
 
       else if (cmd == "ping") {
         if (data.contains("message"))
-          std::cout << std::string(data["message"]) << std::endl;
+          LOG_INFO(std::string(data["message"]));
         returnValue["response"] = data;
       } else if (cmd == "Update") {
         updateEntites.clear();
-        std::chrono::time_point<std::chrono::system_clock> end =
-            std::chrono::system_clock::now();
+        std::chrono::time_point<std::chrono::steady_clock> end =
+            std::chrono::steady_clock::now();
         std::chrono::duration<double> diff = end - start;
         double delta = diff.count() - time;
         time += delta;
         double simSpeed = data["simSpeed"];
-        delta *= simSpeed;
-        if (delta > 0.1) {
-          for (float f = 0.0; f < delta; f += 0.01) {
-            model.update(0.01);
-          }
-        } else {
-          model.update(delta);
+        if (data.contains("maxSteps")) {
+          clock.setMaxSteps(static_cast<int>(data["maxSteps"]));
         }
+
+        // whole fixed steps only; a long stall runs at most maxSteps of them
+        // per unit of sim speed
+        int steps = clock.advance(delta, simSpeed);
+        for (int i = 0; i < steps; ++i) {
+          model.update(clock.getStep());
+        }
+        if (recorder) recorder->advance(model.getTicks());
         for (auto &[id, entity] : updateEntites) {
           sendEntity("UpdateEntity", *entity);
         }
+        // lets the view interpolate between the last two steps
+        returnValue["simTime"] = clock.getTime();
+        returnValue["alpha"] = clock.getAlpha();
       } else if (cmd == "stopSimulation") {
-        std::cout << "Stop command administered\n";
+        LOG_INFO("Stop command administered");
         stopped = true;
         model.stop();
       } else if (cmd == "writeStats") {
         // handle data collection here
-        DataCollectionManager::getInstance()
-            ->exportLog();  // should take care of everything from here
+        model.logSleepingTime();
+        model.getContext()
+            .getDataCollection()
+            .exportLog();  // should take care of everything from here
       }
     } catch (const std::exception &e) {
-      std::cerr << "Error handling command " << cmd << ": " << e.what()
-                << std::endl;
+      LOG_ERROR("Error handling command " << cmd << ": " << e.what());
       // Create an error response
       JsonObject errorDetails;
       errorDetails["command"] = cmd;
@@ -108,6 +154,11 @@ class TransitService : public JsonSession, public IController {
 
   void sendEntity(const std::string &event, const IEntity &entity,
                   bool includeDetails = true) {
+    sendEventToView(event, describeEntity(entity, includeDetails));
+  }
+
+  /// The state of an entity as the view reads it
+  JsonObject describeEntity(const IEntity &entity, bool includeDetails) {
     // JsonObject details = entity.GetDetails();
     JsonObject details;
     if (includeDetails) {
@@ -130,14 +181,25 @@ class TransitService : public JsonSession, public IController {
         details["priorityLevel"] = package->getPriorityLevel();
       }
     }
-
-    sendEventToView(event, details);
+    return details;
   }
 
   void addEntity(const IEntity &entity) {
     sendEntity("AddEntity", entity, true);
   }
 
+  /// Sends a whole batch in one message; each entry reads like the details
+  /// of an AddEntity event
+  void addEntities(const std::vector<IEntity *> &entities) {
+    JsonArray added;
+    for (const IEntity *entity : entities) {
+      added.push(describeEntity(*entity, true));
+    }
+    JsonObject details;
+    details["entities"] = added;
+    sendEventToView("AddEntities", details);
+  }
+
   void updateEntity(const IEntity &entity) {
     updateEntites[entity.getId()] = &entity;
   }
@@ -168,25 +230,48 @@ class TransitService : public JsonSession, public IController {
   // Simulation Model
   SimulationModel model;
   // Used for tracking time since last update
-  std::chrono::time_point<std::chrono::system_clock> start;
+  std::chrono::time_point<std::chrono::steady_clock> start;
   // The total time the server has been running.
   double time;
+  // Turns frame times into fixed simulation steps
+  FixedStepClock clock;
   // Current entities to update
   std::map<int, const IEntity *> updateEntites;
+  // Writes the commands of the session to a log, null when not recording
+  std::unique_ptr<CommandRecorder> recorder;
 };
 
 /// The main program that handles starting the web sockets service.
 int main(int argc, char **argv) {
-  if (argc > 1) {
+  if (argc > 2) {
     int port = std::atoi(argv[1]);
     std::string webDir = std::string(argv[2]);
+    for (int i = 3; i < argc; i++) {
+      std::string arg = argv[i];
+      if (arg == "--record" && i + 1 < argc) {
+        recordPrefix = argv[++i];
+      } else if (arg == "--sync-atc") {
+        syncATC = true;
+      } else if (arg == "--retire-delivered") {
+        retireDelivered = true;
+      } else if (arg == "--log-level" && i + 1 < argc) {
+        LogLevel level;
+        if (Log::parseLevel(argv[++i], level)) Log::setLevel(level);
+      }
+    }
+    // the threaded ATC hands back its commands a tick or more late,
+    // depending on scheduling, so a recording only replays bit for bit
+    // with the ATC on the simulation thread
+    if (!recordPrefix.empty()) syncATC = true;
     WebServer<TransitService> server(port, webDir);
     while (!stopped) {
       server.service();
     }
   } else {
     std::cout
-        << "Usage: ./build/bin/transit_service <port> apps/transit_service/web/"
+        << "Usage: ./build/bin/transit_service <port> apps/transit_service/web/ "
+           "[--record prefix] [--sync-atc] [--retire-delivered] "
+           "[--log-level level]"
         << std::endl;
   }
 
@@ -0,0 +1,532 @@
+#include "ConflictDetector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+#include "Snapshot.h"
+
+ConflictDetector::ConflictDetector() : solver(altitudeThreshold) {}
+
+void ConflictDetector::process(const FlightSnapshot& snapshot,
+                               std::vector<ATCCommand>& commands) {
+  this->snapshot = &snapshot;
+  this->commands = &commands;
+
+  // reroutes the simulation has applied show up in the snapshot itself
+  std::erase_if(pendingReroutes, [&snapshot](const auto& reroute) {
+    return reroute.second <= snapshot.appliedCommands;
+  });
+  reconcile();
+
+  if (schedulePairs.empty() || schedulePairs.front().time > snapshot.time) {
+    emit(ATCCommand::Type::LogSystem, -1, "skipped_evaluations", 1.0);
+  } else {
+    emit(ATCCommand::Type::LogSystem, -1, "evaluations", 1.0);
+    evaluate();
+  }
+
+  this->snapshot = nullptr;
+  this->commands = nullptr;
+}
+
+void ConflictDetector::reconcile() {
+  const std::vector<FlightState>& entities = snapshot->entities;
+  slots.clear();
+  for (size_t slot = 0; slot < entities.size(); ++slot) {
+    slots[entities[slot].handle] = slot;
+  }
+
+  // drop handles that left the simulation, ending their conflicts
+  for (auto it = epochs.begin(); it != epochs.end();) {
+    if (slots.count(it->first)) {
+      ++it;
+      continue;
+    }
+    int handle = it->first;
+    for (auto episode = activeConflicts.begin();
+         episode != activeConflicts.end();) {
+      if (episode->first.first == handle || episode->first.second == handle) {
+        episode = closeConflict(episode);
+      } else {
+        ++episode;
+      }
+    }
+    pendingReroutes.erase(handle);
+    airspaceTree.remove(handle);
+    it = epochs.erase(it);
+    // scheduled pairs of the removed handle are dropped when they come up
+  }
+
+  // refit the airspace tree; only boxes that were reinserted can overlap
+  // boxes they did not overlap before
+  std::vector<size_t> added;
+  std::vector<size_t> moved;
+  for (size_t slot = 0; slot < entities.size(); ++slot) {
+    const FlightState& state = entities[slot];
+    bool isNew = epochs.try_emplace(state.handle, 0).second;
+    bool reinserted = airspaceTree.update(state.handle, airspace(state),
+                                          airspaceMargin(state));
+    if (isNew) {
+      added.push_back(slot);
+    } else if (reinserted) {
+      moved.push_back(slot);
+    }
+  }
+
+  for (size_t slot : added) scheduleAllPairs(slot);
+  for (size_t slot : moved) discoverPairs(slot);
+  for (int handle : snapshot->routeChanges) {
+    auto it = slots.find(handle);
+    if (it != slots.end()) scheduleAllPairs(it->second);
+  }
+}
+
+double ConflictDetector::lookAheadTime(double speed) {
+  return baseCollisionTime + lookAheadPerSpeed * speed;
+}
+
+SweptCapsuleTree::Capsule ConflictDetector::airspace(const FlightState& state) {
+  // a pair uses the shorter horizon of the two, so each capsule covers it
+  SweptCapsuleTree::Capsule capsule;
+  capsule.start = state.position;
+  capsule.end = state.position + state.direction.unit() * state.speed *
+                                     lookAheadTime(state.speed);
+  capsule.radius = 0.5 * collisionDistanceThreshold;
+  return capsule;
+}
+
+double ConflictDetector::airspaceMargin(const FlightState& state) {
+  return state.speed * marginTime + 1.0;
+}
+
+bool ConflictDetector::ScheduledPair::operator>(
+    const ScheduledPair& other) const {
+  if (time != other.time) return time > other.time;
+  if (a != other.a) return a > other.a;
+  return b > other.b;
+}
+
+void ConflictDetector::schedule(double time, size_t i, size_t j) {
+  int handleA = snapshot->entities[i].handle;
+  int handleB = snapshot->entities[j].handle;
+  // keep pairs in registration order so the earlier entity reroutes first
+  if (handleA > handleB) std::swap(handleA, handleB);
+  unsigned long epochA = epochs.at(handleA);
+  unsigned long epochB = epochs.at(handleB);
+  schedulePairs.push_back({time, handleA, handleB, epochA, epochB});
+  std::push_heap(schedulePairs.begin(), schedulePairs.end(),
+                 std::greater<ScheduledPair>());
+  trackedPairs[{handleA, handleB}] = {epochA, epochB};
+}
+
+bool ConflictDetector::isTracked(int a, int b) const {
+  auto tracked = trackedPairs.find(std::minmax(a, b));
+  if (tracked == trackedPairs.end()) return false;
+  const auto& [first, second] = tracked->first;
+  return tracked->second ==
+         std::make_pair(epochs.at(first), epochs.at(second));
+}
+
+void ConflictDetector::scheduleAllPairs(size_t slot) {
+  int handle = snapshot->entities[slot].handle;
+  epochs.at(handle) = ++nextEpoch;
+
+  std::vector<int> partners;
+  airspaceTree.queryOverlaps(handle, partners);
+  for (int partner : partners) {
+    auto other = slots.find(partner);
+    if (other != slots.end()) schedule(snapshot->time, slot, other->second);
+  }
+
+  // every live pair has at most one current entry, the rest are stale
+  size_t n = snapshot->entities.size();
+  if (schedulePairs.size() > n * (n - 1) + 64) compactSchedule();
+}
+
+void ConflictDetector::discoverPairs(size_t slot) {
+  int handle = snapshot->entities[slot].handle;
+  std::vector<int> partners;
+  airspaceTree.queryOverlaps(handle, partners);
+  for (int partner : partners) {
+    auto other = slots.find(partner);
+    if (other != slots.end() && !isTracked(handle, partner)) {
+      schedule(snapshot->time, slot, other->second);
+    }
+  }
+}
+
+void ConflictDetector::compactSchedule() {
+  auto stale = [this](int a, int b, unsigned long epochA,
+                      unsigned long epochB) {
+    auto itA = epochs.find(a);
+    auto itB = epochs.find(b);
+    return itA == epochs.end() || itB == epochs.end() ||
+           itA->second != epochA || itB->second != epochB;
+  };
+  std::erase_if(schedulePairs, [&stale](const ScheduledPair& pair) {
+    return stale(pair.a, pair.b, pair.epochA, pair.epochB);
+  });
+  std::erase_if(trackedPairs, [&stale](const auto& tracked) {
+    return stale(tracked.first.first, tracked.first.second,
+                 tracked.second.first, tracked.second.second);
+  });
+  std::make_heap(schedulePairs.begin(), schedulePairs.end(),
+                 std::greater<ScheduledPair>());
+}
+
+void ConflictDetector::evaluate() {
+  const std::vector<FlightState>& entities = snapshot->entities;
+
+  // pop everything that is due first, since pairs still in conflict are
+  // rescheduled for the current time
+  std::vector<ScheduledPair> due;
+  while (!schedulePairs.empty() &&
+         schedulePairs.front().time <= snapshot->time) {
+    std::pop_heap(schedulePairs.begin(), schedulePairs.end(),
+                  std::greater<ScheduledPair>());
+    due.push_back(schedulePairs.back());
+    schedulePairs.pop_back();
+  }
+
+  std::vector<size_t> conflicted;
+  std::vector<bool> inConflict(entities.size(), false);
+  // seconds each conflicted entity must hold its new course
+  std::vector<double> holdTimes(entities.size(), 0);
+  double pairEvaluations = 0;
+  for (const ScheduledPair& pair : due) {
+    auto a = slots.find(pair.a);
+    auto b = slots.find(pair.b);
+    if (a == slots.end() || b == slots.end()) continue;
+    // a route change since scheduling means a fresher entry exists
+    if (epochs.at(pair.a) != pair.epochA || epochs.at(pair.b) != pair.epochB) {
+      continue;
+    }
+    size_t i = a->second;
+    size_t j = b->second;
+
+    ++pairEvaluations;
+    if (evaluatePair(i, j)) {
+      double holdTime = timeToClosestApproach(entities[i], entities[j]);
+      for (size_t slot : {i, j}) {
+        holdTimes[slot] = std::max(holdTimes[slot], holdTime);
+        if (!inConflict[slot]) {
+          inConflict[slot] = true;
+          conflicted.push_back(slot);
+        }
+      }
+    }
+
+    // open episodes are checked every update until they close; pairs whose
+    // airspace separated are found again by the tree once it overlaps
+    if (activeConflicts.count(std::minmax(pair.a, pair.b))) {
+      schedule(snapshot->time, i, j);
+    } else if (airspaceTree.overlaps(pair.a, pair.b)) {
+      schedule(snapshot->time +
+                   timeUntilPossibleConflict(entities[i], entities[j]),
+               i, j);
+    } else {
+      trackedPairs.erase({pair.a, pair.b});
+    }
+  }
+  if (pairEvaluations > 0) {
+    emit(ATCCommand::Type::LogSystem, -1, "pair_evaluations", pairEvaluations);
+  }
+
+  if (!conflicted.empty()) resolveConflicts(conflicted, holdTimes);
+}
+
+bool ConflictDetector::evaluatePair(size_t i, size_t j) {
+  const FlightState& a = snapshot->entities[i];
+  const FlightState& b = snapshot->entities[j];
+  auto episode = activeConflicts.find(std::minmax(a.handle, b.handle));
+  double separation = (a.position - b.position).magnitude();
+
+  if (!willCollide(a, b)) {
+    if (episode != activeConflicts.end()) {
+      ConflictEpisode& conflict = episode->second;
+      conflict.minSeparation = std::min(conflict.minSeparation, separation);
+      if (snapshot->time - conflict.lastSeen >= conflictExitTime) {
+        closeConflict(episode);
+      }
+    }
+    return false;
+  }
+
+  if (episode == activeConflicts.end()) {
+    emit(ATCCommand::Type::Log, a.handle, "potential_collisions", 1.0);
+    emit(ATCCommand::Type::Log, b.handle, "potential_collisions", 1.0);
+    episode = activeConflicts
+                  .emplace(std::minmax(a.handle, b.handle),
+                           ConflictEpisode{snapshot->time, snapshot->time,
+                                           separation})
+                  .first;
+  }
+  ConflictEpisode& conflict = episode->second;
+  conflict.lastSeen = snapshot->time;
+  conflict.minSeparation = std::min(conflict.minSeparation, separation);
+
+  if (isRerouted(i) && isRerouted(j)) {
+    if (!conflict.unavoidable) {
+      emit(ATCCommand::Type::Log, a.handle, "collision_unavoidable", 1.0);
+      conflict.unavoidable = true;
+    }
+    return false;
+  }
+  return true;
+}
+
+std::map<std::pair<int, int>, ConflictDetector::ConflictEpisode>::iterator
+ConflictDetector::closeConflict(
+    std::map<std::pair<int, int>, ConflictEpisode>::iterator episode) {
+  const ConflictEpisode& conflict = episode->second;
+  double duration = conflict.lastSeen - conflict.start;
+  for (int handle : {episode->first.first, episode->first.second}) {
+    // removed entities have no log left to write to
+    if (!slots.count(handle)) continue;
+    emit(ATCCommand::Type::Log, handle, "conflict_duration", duration);
+    emit(ATCCommand::Type::LogMinimum, handle, "min_conflict_separation",
+         conflict.minSeparation);
+  }
+  emit(ATCCommand::Type::LogSystem, -1, "conflict_episodes", 1.0);
+  return activeConflicts.erase(episode);
+}
+
+void ConflictDetector::resolveConflicts(const std::vector<size_t>& conflicted,
+                                        const std::vector<double>& holdTimes) {
+  const std::vector<FlightState>& entities = snapshot->entities;
+
+  // every flying entity is an obstacle; entities mid-reroute hold course
+  std::vector<VelocityObstacleSolver::Agent> agents(entities.size());
+  for (size_t slot = 0; slot < entities.size(); ++slot) {
+    const FlightState& state = entities[slot];
+    VelocityObstacleSolver::Agent& agent = agents[slot];
+    agent.position = state.position;
+    agent.velocity = state.direction.unit() * state.speed;
+    agent.radius = 0.6 * collisionDistanceThreshold;
+    agent.maxSpeed = state.speed;
+    // same look-ahead as willCollide; an equally fast neighbour further away
+    // than range cannot close in within it
+    agent.horizon = lookAheadTime(state.speed);
+    agent.range =
+        2 * state.speed * agent.horizon + collisionDistanceThreshold;
+    agent.responsive = !isRerouted(slot);
+    // detours are flown at full speed
+    agent.fixedSpeed = true;
+  }
+
+  std::vector<size_t> batch;
+  for (size_t slot : conflicted) {
+    if (agents[slot].responsive) batch.push_back(slot);
+  }
+  std::vector<Vector3> velocities = solver.solve(agents, batch);
+  std::vector<Vector3> newVelocities(agents.size());
+  for (size_t slot = 0; slot < agents.size(); ++slot) {
+    newVelocities[slot] = agents[slot].velocity;
+  }
+  for (size_t k = 0; k < batch.size(); ++k) {
+    newVelocities[batch[k]] = velocities[k];
+  }
+
+  for (size_t k = 0; k < batch.size(); ++k) {
+    size_t slot = batch[k];
+    int handle = entities[slot].handle;
+    const Vector3& velocity = velocities[k];
+
+    // the current course is already collision free for this entity
+    double tolerance = 1e-3 * std::max(agents[slot].maxSpeed, 1.0);
+    if ((velocity - agents[slot].velocity).magnitude() <= tolerance) continue;
+
+    if (velocity.magnitude() <= tolerance) {
+      emit(ATCCommand::Type::Log, handle, "collision_unavoidable", 1.0);
+      continue;
+    }
+
+    // hold the detour until the entity is past its conflicts on the new
+    // courses and the combined radius has opened up again; turning back at
+    // the closest approach starts the next conflict
+    double holdTime = holdTimes[slot];
+    for (size_t other : conflicted) {
+      if (other == slot) continue;
+      Vector3 relPos = agents[other].position - agents[slot].position;
+      Vector3 relVel = newVelocities[other] - velocity;
+      double relSpeedSquared = relVel * relVel;
+      if (relSpeedSquared < 1) continue;
+      double combinedRadius = agents[slot].radius + agents[other].radius;
+      holdTime = std::max(holdTime, -(relPos * relVel) / relSpeedSquared +
+                                        combinedRadius /
+                                            std::sqrt(relSpeedSquared));
+    }
+
+    ATCCommand& reroute =
+        emit(ATCCommand::Type::Reroute, handle, nullptr, holdTime);
+    reroute.velocity = velocity;
+    pendingReroutes[handle] = reroute.sequence;
+    scheduleAllPairs(slot);
+    emit(ATCCommand::Type::Log, handle, "reroute_count", 1.0);
+  }
+}
+
+bool ConflictDetector::isRerouted(size_t slot) const {
+  const FlightState& state = snapshot->entities[slot];
+  return state.rerouted || pendingReroutes.count(state.handle);
+}
+
+ATCCommand& ConflictDetector::emit(ATCCommand::Type type, int handle,
+                                   const char* name, double value) {
+  ATCCommand command;
+  command.type = type;
+  command.handle = handle;
+  command.name = name;
+  command.value = value;
+  command.sequence = ++nextSequence;
+  commands->push_back(command);
+  return commands->back();
+}
+
+double ConflictDetector::timeToClosestApproach(const FlightState& a,
+                                               const FlightState& b) const {
+  Vector3 relPos = b.position - a.position;
+  Vector3 relVel =
+      b.direction.unit() * b.speed - a.direction.unit() * a.speed;
+  double relSpeedSquared = relVel * relVel;
+  if (relSpeedSquared < 1) return 0;
+  return std::max(0.0, -(relPos * relVel) / relSpeedSquared);
+}
+
+double ConflictDetector::timeUntilPossibleConflict(
+    const FlightState& a, const FlightState& b) const {
+  double closingSpeed = a.speed + b.speed;
+  double horizon = std::min(lookAheadTime(a.speed), lookAheadTime(b.speed));
+
+  // willCollide only reports pairs that can close to the separation minimum
+  // within the horizon and share the altitude band
+  double margin =
+      std::max((a.position - b.position).magnitude() -
+                   collisionDistanceThreshold - closingSpeed * horizon,
+               std::abs(a.position.y - b.position.y) - altitudeThreshold);
+  if (margin <= 0) return 0;
+  if (closingSpeed <= 0) return std::numeric_limits<double>::infinity();
+  return margin / closingSpeed;
+}
+
+bool ConflictDetector::willCollide(const FlightState& a,
+                                   const FlightState& b) const {
+  Vector3 posA = a.position;
+  Vector3 posB = b.position;
+  Vector3 dirA = a.direction.unit();
+  Vector3 dirB = b.direction.unit();
+  float speedA = a.speed;
+  float speedB = b.speed;
+
+  float altitudeDiff = std::abs(posA.y - posB.y);
+  if (altitudeDiff > altitudeThreshold) {
+    return false;
+  }
+
+  float collisionTimeThreshold =
+      std::min(lookAheadTime(speedA), lookAheadTime(speedB));
+  float currentDistance = (posA - posB).magnitude();
+
+  Vector3 relPos = posB - posA;
+  Vector3 relVel = dirB * speedB - dirA * speedA;
+
+  float relSpeedSquared = relVel * relVel;
+  if (relSpeedSquared < 1) {
+    return currentDistance < collisionDistanceThreshold;
+  }
+
+  float tClosest = -(relPos * relVel) / relSpeedSquared;
+
+  if (tClosest < 0 || tClosest > collisionTimeThreshold) {
+    return false;
+  }
+
+  Vector3 futurePosA = posA + dirA * speedA * tClosest;
+  Vector3 futurePosB = posB + dirB * speedB * tClosest;
+  float distanceAtClosest = (futurePosA - futurePosB).magnitude();
+
+  return distanceAtClosest < collisionDistanceThreshold;
+}
+
+void ConflictDetector::save(SnapshotWriter& out) const {
+  // hash maps are written in key order, so equal states give equal bytes
+  std::map<int, unsigned long> sortedEpochs(epochs.begin(), epochs.end());
+  out.write(static_cast<std::uint64_t>(sortedEpochs.size()));
+  for (const auto& [handle, epoch] : sortedEpochs) {
+    out.write(handle);
+    out.write(epoch);
+  }
+  std::map<int, unsigned long> sortedReroutes(pendingReroutes.begin(),
+                                              pendingReroutes.end());
+  out.write(static_cast<std::uint64_t>(sortedReroutes.size()));
+  for (const auto& [handle, sequence] : sortedReroutes) {
+    out.write(handle);
+    out.write(sequence);
+  }
+  out.write(nextSequence);
+  std::map<std::pair<int, int>, std::pair<unsigned long, unsigned long>>
+      sortedPairs(trackedPairs.begin(), trackedPairs.end());
+  out.write(static_cast<std::uint64_t>(sortedPairs.size()));
+  for (const auto& [pair, pairEpochs] : sortedPairs) {
+    out.write(pair.first);
+    out.write(pair.second);
+    out.write(pairEpochs.first);
+    out.write(pairEpochs.second);
+  }
+  // the heap is written as is, so pairs come up in the same order
+  out.write(static_cast<std::uint64_t>(schedulePairs.size()));
+  for (const ScheduledPair& pair : schedulePairs) out.write(pair);
+  out.write(nextEpoch);
+  out.write(static_cast<std::uint64_t>(activeConflicts.size()));
+  // field by field, so the padding after the flag is not written
+  for (const auto& [pair, episode] : activeConflicts) {
+    out.write(pair.first);
+    out.write(pair.second);
+    out.write(episode.start);
+    out.write(episode.lastSeen);
+    out.write(episode.minSeparation);
+    out.write(episode.unavoidable);
+  }
+  airspaceTree.save(out);
+}
+
+void ConflictDetector::load(SnapshotReader& in) {
+  epochs.clear();
+  std::uint64_t count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    int handle = in.read<int>();
+    epochs[handle] = in.read<unsigned long>();
+  }
+  pendingReroutes.clear();
+  count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    int handle = in.read<int>();
+    pendingReroutes[handle] = in.read<unsigned long>();
+  }
+  nextSequence = in.read<unsigned long>();
+  trackedPairs.clear();
+  count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    int a = in.read<int>();
+    int b = in.read<int>();
+    unsigned long epochA = in.read<unsigned long>();
+    trackedPairs[{a, b}] = {epochA, in.read<unsigned long>()};
+  }
+  schedulePairs.resize(in.read<std::uint64_t>());
+  for (ScheduledPair& pair : schedulePairs) pair = in.read<ScheduledPair>();
+  nextEpoch = in.read<unsigned long>();
+  activeConflicts.clear();
+  count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    int a = in.read<int>();
+    int b = in.read<int>();
+    ConflictEpisode& episode = activeConflicts[{a, b}];
+    episode.start = in.read<double>();
+    episode.lastSeen = in.read<double>();
+    episode.minSeparation = in.read<double>();
+    episode.unavoidable = in.read<bool>();
+  }
+  airspaceTree.load(in);
+}
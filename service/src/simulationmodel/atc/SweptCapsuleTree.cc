@@ -0,0 +1,308 @@
+#include "SweptCapsuleTree.h"
+
+#include <algorithm>
+#include <map>
+
+#include "Snapshot.h"
+
+namespace {
+
+const double kEpsilon = 1e-9;
+
+// Squared distance between segments p1-q1 and p2-q2 (Ericson, "Real-Time
+// Collision Detection", 5.1.9).
+double segmentDistanceSquared(const Vector3& p1, const Vector3& q1,
+                              const Vector3& p2, const Vector3& q2) {
+  Vector3 d1 = q1 - p1;
+  Vector3 d2 = q2 - p2;
+  Vector3 r = p1 - p2;
+  double a = d1 * d1;
+  double e = d2 * d2;
+  double f = d2 * r;
+
+  double s = 0;
+  double t = 0;
+  if (a <= kEpsilon && e <= kEpsilon) {
+    return r * r;
+  } else if (a <= kEpsilon) {
+    t = std::clamp(f / e, 0.0, 1.0);
+  } else {
+    double c = d1 * r;
+    if (e <= kEpsilon) {
+      s = std::clamp(-c / a, 0.0, 1.0);
+    } else {
+      double b = d1 * d2;
+      double denominator = a * e - b * b;
+      // parallel segments: any s works, start from the first endpoint
+      if (denominator > kEpsilon) {
+        s = std::clamp((b * f - c * e) / denominator, 0.0, 1.0);
+      }
+      t = (b * s + f) / e;
+      if (t < 0) {
+        t = 0;
+        s = std::clamp(-c / a, 0.0, 1.0);
+      } else if (t > 1) {
+        t = 1;
+        s = std::clamp((b - c) / a, 0.0, 1.0);
+      }
+    }
+  }
+
+  Vector3 closest = (p1 + d1 * s) - (p2 + d2 * t);
+  return closest * closest;
+}
+
+}  // namespace
+
+bool SweptCapsuleTree::Box::overlaps(const Box& other) const {
+  return min.x <= other.max.x && max.x >= other.min.x &&
+         min.y <= other.max.y && max.y >= other.min.y &&
+         min.z <= other.max.z && max.z >= other.min.z;
+}
+
+bool SweptCapsuleTree::Box::contains(const Box& other) const {
+  return min.x <= other.min.x && max.x >= other.max.x &&
+         min.y <= other.min.y && max.y >= other.max.y &&
+         min.z <= other.min.z && max.z >= other.max.z;
+}
+
+SweptCapsuleTree::Box SweptCapsuleTree::Box::merge(const Box& other) const {
+  return {Vector3(std::min(min.x, other.min.x), std::min(min.y, other.min.y),
+                  std::min(min.z, other.min.z)),
+          Vector3(std::max(max.x, other.max.x), std::max(max.y, other.max.y),
+                  std::max(max.z, other.max.z))};
+}
+
+double SweptCapsuleTree::Box::area() const {
+  Vector3 size = max - min;
+  return 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+SweptCapsuleTree::Box SweptCapsuleTree::bounds(const Capsule& capsule) {
+  Vector3 radius(capsule.radius, capsule.radius, capsule.radius);
+  Box box{Vector3(std::min(capsule.start.x, capsule.end.x),
+                  std::min(capsule.start.y, capsule.end.y),
+                  std::min(capsule.start.z, capsule.end.z)),
+          Vector3(std::max(capsule.start.x, capsule.end.x),
+                  std::max(capsule.start.y, capsule.end.y),
+                  std::max(capsule.start.z, capsule.end.z))};
+  box.min = box.min - radius;
+  box.max = box.max + radius;
+  return box;
+}
+
+bool SweptCapsuleTree::intersects(const Capsule& a, const Capsule& b) {
+  double reach = a.radius + b.radius;
+  return segmentDistanceSquared(a.start, a.end, b.start, b.end) <=
+         reach * reach;
+}
+
+bool SweptCapsuleTree::update(int handle, const Capsule& capsule,
+                              double margin) {
+  Box tight = bounds(capsule);
+  int leaf;
+  auto it = leaves.find(handle);
+  if (it != leaves.end()) {
+    leaf = it->second;
+    nodes[leaf].capsule = capsule;
+    if (nodes[leaf].box.contains(tight)) return false;
+    removeLeaf(leaf);
+  } else {
+    leaf = allocateNode();
+    nodes[leaf].handle = handle;
+    leaves[handle] = leaf;
+  }
+
+  Vector3 fat(margin, margin, margin);
+  nodes[leaf].capsule = capsule;
+  nodes[leaf].box = {tight.min - fat, tight.max + fat};
+  insertLeaf(leaf);
+  return true;
+}
+
+void SweptCapsuleTree::remove(int handle) {
+  auto it = leaves.find(handle);
+  if (it == leaves.end()) return;
+  removeLeaf(it->second);
+  freeNode(it->second);
+  leaves.erase(it);
+}
+
+bool SweptCapsuleTree::contains(int handle) const {
+  return leaves.count(handle) > 0;
+}
+
+size_t SweptCapsuleTree::size() const { return leaves.size(); }
+
+void SweptCapsuleTree::query(const Capsule& capsule,
+                             std::vector<int>& handles) const {
+  if (root < 0) return;
+  Box box = bounds(capsule);
+  std::vector<int> stack = {root};
+  while (!stack.empty()) {
+    const Node& node = nodes[stack.back()];
+    stack.pop_back();
+    if (!node.box.overlaps(box)) continue;
+    if (node.isLeaf()) {
+      if (intersects(node.capsule, capsule)) handles.push_back(node.handle);
+    } else {
+      stack.push_back(node.left);
+      stack.push_back(node.right);
+    }
+  }
+}
+
+void SweptCapsuleTree::queryOverlaps(int handle,
+                                     std::vector<int>& handles) const {
+  auto it = leaves.find(handle);
+  if (it == leaves.end()) return;
+  const Box& box = nodes[it->second].box;
+  std::vector<int> stack = {root};
+  while (!stack.empty()) {
+    int index = stack.back();
+    const Node& node = nodes[index];
+    stack.pop_back();
+    if (!node.box.overlaps(box)) continue;
+    if (node.isLeaf()) {
+      if (index != it->second) handles.push_back(node.handle);
+    } else {
+      stack.push_back(node.left);
+      stack.push_back(node.right);
+    }
+  }
+}
+
+bool SweptCapsuleTree::overlaps(int a, int b) const {
+  auto leafA = leaves.find(a);
+  auto leafB = leaves.find(b);
+  if (leafA == leaves.end() || leafB == leaves.end()) return false;
+  return nodes[leafA->second].box.overlaps(nodes[leafB->second].box);
+}
+
+int SweptCapsuleTree::allocateNode() {
+  if (freeNodes.empty()) {
+    nodes.emplace_back();
+    return nodes.size() - 1;
+  }
+  int node = freeNodes.back();
+  freeNodes.pop_back();
+  nodes[node] = Node();
+  return node;
+}
+
+void SweptCapsuleTree::freeNode(int node) {
+  nodes[node] = Node();
+  freeNodes.push_back(node);
+}
+
+void SweptCapsuleTree::insertLeaf(int leaf) {
+  if (root < 0) {
+    root = leaf;
+    nodes[leaf].parent = -1;
+    return;
+  }
+
+  // descend towards the sibling that grows the total surface area least
+  Box box = nodes[leaf].box;
+  int index = root;
+  while (!nodes[index].isLeaf()) {
+    const Node& node = nodes[index];
+    double combined = node.box.merge(box).area();
+    // pairing with this node creates a parent as big as the merged box
+    double cost = 2 * combined;
+    // descending enlarges this node either way
+    double inheritance = 2 * (combined - node.box.area());
+
+    auto descendCost = [&](int child) {
+      const Box& childBox = nodes[child].box;
+      double merged = childBox.merge(box).area();
+      if (nodes[child].isLeaf()) return merged + inheritance;
+      return merged - childBox.area() + inheritance;
+    };
+    double costLeft = descendCost(node.left);
+    double costRight = descendCost(node.right);
+
+    if (cost < costLeft && cost < costRight) break;
+    index = costLeft < costRight ? node.left : node.right;
+  }
+
+  int sibling = index;
+  int oldParent = nodes[sibling].parent;
+  int newParent = allocateNode();
+  nodes[newParent].parent = oldParent;
+  nodes[newParent].box = nodes[sibling].box.merge(box);
+  nodes[newParent].left = sibling;
+  nodes[newParent].right = leaf;
+  nodes[sibling].parent = newParent;
+  nodes[leaf].parent = newParent;
+
+  if (oldParent < 0) {
+    root = newParent;
+  } else if (nodes[oldParent].left == sibling) {
+    nodes[oldParent].left = newParent;
+  } else {
+    nodes[oldParent].right = newParent;
+  }
+  refitAncestors(oldParent);
+}
+
+void SweptCapsuleTree::removeLeaf(int leaf) {
+  if (leaf == root) {
+    root = -1;
+    return;
+  }
+
+  int parent = nodes[leaf].parent;
+  int grandParent = nodes[parent].parent;
+  int sibling =
+      nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+  // the sibling takes the place of the parent
+  nodes[sibling].parent = grandParent;
+  if (grandParent < 0) {
+    root = sibling;
+  } else if (nodes[grandParent].left == parent) {
+    nodes[grandParent].left = sibling;
+  } else {
+    nodes[grandParent].right = sibling;
+  }
+  freeNode(parent);
+  nodes[leaf].parent = -1;
+  refitAncestors(grandParent);
+}
+
+void SweptCapsuleTree::refitAncestors(int node) {
+  while (node >= 0) {
+    Node& current = nodes[node];
+    current.box = nodes[current.left].box.merge(nodes[current.right].box);
+    node = current.parent;
+  }
+}
+
+void SweptCapsuleTree::save(SnapshotWriter& out) const {
+  out.write(static_cast<std::uint64_t>(nodes.size()));
+  for (const Node& node : nodes) out.write(node);
+  out.write(static_cast<std::uint64_t>(freeNodes.size()));
+  for (int node : freeNodes) out.write(node);
+  out.write(root);
+  std::map<int, int> sortedLeaves(leaves.begin(), leaves.end());
+  out.write(static_cast<std::uint64_t>(sortedLeaves.size()));
+  for (const auto& [handle, leaf] : sortedLeaves) {
+    out.write(handle);
+    out.write(leaf);
+  }
+}
+
+void SweptCapsuleTree::load(SnapshotReader& in) {
+  nodes.resize(in.read<std::uint64_t>());
+  for (Node& node : nodes) node = in.read<Node>();
+  freeNodes.resize(in.read<std::uint64_t>());
+  for (int& node : freeNodes) node = in.read<int>();
+  root = in.read<int>();
+  leaves.clear();
+  std::uint64_t count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    int handle = in.read<int>();
+    leaves[handle] = in.read<int>();
+  }
+}
@@ -0,0 +1,285 @@
+#include "VelocityObstacleSolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// The half-plane construction and linear programs follow the reference ORCA
+// formulation (van den Berg et al., "Reciprocal n-body Collision Avoidance").
+namespace {
+
+const double kEpsilon = 1e-5;
+
+struct Vec2 {
+  double x = 0;
+  double y = 0;
+
+  Vec2() {}
+  Vec2(double x, double y) : x(x), y(y) {}
+
+  Vec2 operator+(const Vec2& v) const { return {x + v.x, y + v.y}; }
+  Vec2 operator-(const Vec2& v) const { return {x - v.x, y - v.y}; }
+  Vec2 operator-() const { return {-x, -y}; }
+  Vec2 operator*(double s) const { return {x * s, y * s}; }
+  double operator*(const Vec2& v) const { return x * v.x + y * v.y; }
+};
+
+double det(const Vec2& a, const Vec2& b) { return a.x * b.y - a.y * b.x; }
+
+double absSq(const Vec2& v) { return v * v; }
+
+// Velocities on the left of the directed line are permitted.
+struct Line {
+  Vec2 point;
+  Vec2 direction;
+};
+
+Vec2 planar(const Vector3& v) { return {v.x, v.z}; }
+
+// Optimise along one line, constrained by the lines before it.
+bool linearProgram1(const std::vector<Line>& lines, size_t lineNo,
+                    double radius, const Vec2& optVelocity, bool directionOpt,
+                    Vec2& result) {
+  const Line& line = lines[lineNo];
+  double dotProduct = line.point * line.direction;
+  double discriminant =
+      dotProduct * dotProduct + radius * radius - absSq(line.point);
+  if (discriminant < 0) return false;
+
+  double sqrtDiscriminant = std::sqrt(discriminant);
+  double tLeft = -dotProduct - sqrtDiscriminant;
+  double tRight = -dotProduct + sqrtDiscriminant;
+
+  for (size_t i = 0; i < lineNo; ++i) {
+    double denominator = det(line.direction, lines[i].direction);
+    double numerator = det(lines[i].direction, line.point - lines[i].point);
+
+    if (std::abs(denominator) <= kEpsilon) {
+      // parallel lines
+      if (numerator < 0) return false;
+      continue;
+    }
+
+    double t = numerator / denominator;
+    if (denominator >= 0) {
+      tRight = std::min(tRight, t);
+    } else {
+      tLeft = std::max(tLeft, t);
+    }
+    if (tLeft > tRight) return false;
+  }
+
+  if (directionOpt) {
+    result = line.point + line.direction * (optVelocity * line.direction > 0
+                                                ? tRight
+                                                : tLeft);
+  } else {
+    double t = line.direction * (optVelocity - line.point);
+    result = line.point + line.direction * std::clamp(t, tLeft, tRight);
+  }
+  return true;
+}
+
+// Returns the number of lines satisfied; lines.size() means success.
+size_t linearProgram2(const std::vector<Line>& lines, double radius,
+                      const Vec2& optVelocity, bool directionOpt,
+                      Vec2& result) {
+  if (directionOpt) {
+    result = optVelocity * radius;
+  } else if (absSq(optVelocity) > radius * radius) {
+    result = optVelocity * (radius / std::sqrt(absSq(optVelocity)));
+  } else {
+    result = optVelocity;
+  }
+
+  for (size_t i = 0; i < lines.size(); ++i) {
+    if (det(lines[i].direction, lines[i].point - result) > 0) {
+      Vec2 previous = result;
+      if (!linearProgram1(lines, i, radius, optVelocity, directionOpt,
+                          result)) {
+        result = previous;
+        return i;
+      }
+    }
+  }
+  return lines.size();
+}
+
+// Infeasible problem: minimise the largest violation instead.
+void linearProgram3(const std::vector<Line>& lines, size_t beginLine,
+                    double radius, Vec2& result) {
+  double distance = 0;
+  for (size_t i = beginLine; i < lines.size(); ++i) {
+    if (det(lines[i].direction, lines[i].point - result) <= distance) {
+      continue;
+    }
+
+    std::vector<Line> projLines;
+    for (size_t j = 0; j < i; ++j) {
+      Line line;
+      double determinant = det(lines[i].direction, lines[j].direction);
+      if (std::abs(determinant) <= kEpsilon) {
+        if (lines[i].direction * lines[j].direction > 0) continue;
+        line.point = (lines[i].point + lines[j].point) * 0.5;
+      } else {
+        line.point = lines[i].point +
+                     lines[i].direction *
+                         (det(lines[j].direction,
+                              lines[i].point - lines[j].point) /
+                          determinant);
+      }
+      Vec2 direction = lines[j].direction - lines[i].direction;
+      line.direction = direction * (1.0 / std::sqrt(absSq(direction)));
+      projLines.push_back(line);
+    }
+
+    Vec2 previous = result;
+    Vec2 optDirection(-lines[i].direction.y, lines[i].direction.x);
+    if (linearProgram2(projLines, radius, optDirection, true, result) <
+        projLines.size()) {
+      result = previous;
+    }
+    distance = det(lines[i].direction, lines[i].point - result);
+  }
+}
+
+// Move a feasible result onto the speed circle, for agents that cannot slow
+// down. Candidates are where the constraint lines cross the circle.
+void keepSpeed(const std::vector<Line>& lines, double radius,
+               const Vec2& velocity, Vec2& result) {
+  if (absSq(result) >= radius * radius * (1 - kEpsilon)) return;
+
+  auto feasible = [&lines](const Vec2& candidate) {
+    for (const Line& line : lines) {
+      if (det(line.direction, line.point - candidate) > kEpsilon) return false;
+    }
+    return true;
+  };
+
+  std::vector<Vec2> candidates;
+  if (absSq(result) > kEpsilon) {
+    candidates.push_back(result * (radius / std::sqrt(absSq(result))));
+  }
+  for (const Line& line : lines) {
+    double dotProduct = line.point * line.direction;
+    double discriminant =
+        dotProduct * dotProduct + radius * radius - absSq(line.point);
+    if (discriminant < 0) continue;
+    double sqrtDiscriminant = std::sqrt(discriminant);
+    candidates.push_back(line.point +
+                         line.direction * (-dotProduct - sqrtDiscriminant));
+    candidates.push_back(line.point +
+                         line.direction * (-dotProduct + sqrtDiscriminant));
+  }
+
+  double best = std::numeric_limits<double>::infinity();
+  for (const Vec2& candidate : candidates) {
+    double distance = absSq(candidate - velocity);
+    if (distance < best && feasible(candidate)) {
+      best = distance;
+      result = candidate;
+    }
+  }
+}
+
+}  // namespace
+
+VelocityObstacleSolver::VelocityObstacleSolver(double altitudeBand)
+    : altitudeBand(altitudeBand) {}
+
+std::vector<Vector3> VelocityObstacleSolver::solve(
+    const std::vector<Agent>& agents,
+    const std::vector<size_t>& conflicted) const {
+  std::vector<bool> inBatch(agents.size(), false);
+  for (size_t index : conflicted) inBatch[index] = true;
+
+  std::vector<Vector3> velocities;
+  velocities.reserve(conflicted.size());
+  for (size_t index : conflicted) {
+    const Agent& agent = agents[index];
+    Vec2 position = planar(agent.position);
+    Vec2 velocity = planar(agent.velocity);
+
+    std::vector<Line> lines;
+    for (size_t other = 0; other < agents.size(); ++other) {
+      if (other == index) continue;
+      const Agent& obstacle = agents[other];
+      if (std::abs(agent.position.y - obstacle.position.y) > altitudeBand) {
+        continue;
+      }
+
+      Vec2 relPosition = planar(obstacle.position) - position;
+      Vec2 relVelocity = velocity - planar(obstacle.velocity);
+      double distSq = absSq(relPosition);
+      double combinedRadius = agent.radius + obstacle.radius;
+      double combinedRadiusSq = combinedRadius * combinedRadius;
+
+      double range = std::max(agent.range, obstacle.range);
+      if (distSq > range * range) continue;
+      double invTimeHorizon =
+          1.0 / std::max(std::max(agent.horizon, obstacle.horizon), kEpsilon);
+
+      Line line;
+      Vec2 u;
+      if (distSq > combinedRadiusSq) {
+        Vec2 w = relVelocity - relPosition * invTimeHorizon;
+        double wLengthSq = absSq(w);
+        double dotProduct = w * relPosition;
+
+        if (dotProduct < 0 &&
+            dotProduct * dotProduct > combinedRadiusSq * wLengthSq) {
+          // project on the cut-off circle
+          double wLength = std::sqrt(wLengthSq);
+          Vec2 unitW = w * (1.0 / wLength);
+          line.direction = Vec2(unitW.y, -unitW.x);
+          u = unitW * (combinedRadius * invTimeHorizon - wLength);
+        } else {
+          // project on the legs of the velocity obstacle
+          double leg = std::sqrt(distSq - combinedRadiusSq);
+          if (det(relPosition, w) > 0) {
+            line.direction = Vec2(relPosition.x * leg -
+                                      relPosition.y * combinedRadius,
+                                  relPosition.x * combinedRadius +
+                                      relPosition.y * leg) *
+                             (1.0 / distSq);
+          } else {
+            line.direction = -Vec2(relPosition.x * leg +
+                                       relPosition.y * combinedRadius,
+                                   -relPosition.x * combinedRadius +
+                                       relPosition.y * leg) *
+                             (1.0 / distSq);
+          }
+          u = line.direction * (relVelocity * line.direction) - relVelocity;
+        }
+      } else {
+        // already overlapping, where the cut-off circle no longer stops
+        // agents flying through each other: move apart fast enough to clear
+        // the overlap over the look-ahead; clearing it within one step
+        // turns agents straight around into the next conflict
+        double dist = std::sqrt(distSq);
+        if (dist <= kEpsilon) continue;
+        Vec2 unitW = relPosition * (-1.0 / dist);
+        line.direction = Vec2(unitW.y, -unitW.x);
+        u = unitW * ((combinedRadius - dist) * invTimeHorizon -
+                     relVelocity * unitW);
+      }
+
+      // share the avoidance only with neighbours adjusting in this batch
+      double responsibility =
+          obstacle.responsive && inBatch[other] ? 0.5 : 1.0;
+      line.point = velocity + u * responsibility;
+      lines.push_back(line);
+    }
+
+    Vec2 result;
+    size_t lineFail =
+        linearProgram2(lines, agent.maxSpeed, velocity, false, result);
+    if (lineFail < lines.size()) {
+      linearProgram3(lines, lineFail, agent.maxSpeed, result);
+    } else if (agent.fixedSpeed) {
+      keepSpeed(lines, agent.maxSpeed, velocity, result);
+    }
+    velocities.push_back(Vector3(result.x, agent.velocity.y, result.y));
+  }
+  return velocities;
+}
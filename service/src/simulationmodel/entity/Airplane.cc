@@ -8,29 +8,32 @@
 #include "BeelineStrategy.h"
 #include "DataCollectionManager.h"
 #include "Package.h"
+#include "SimulationContext.h"
 #include "SimulationModel.h"
+#include "Snapshot.h"
 
 Airplane::Airplane(const JsonObject& obj) : IEntity(obj) {
-  this->lastPosition = this->position;
+  this->lastPosition = this->getPosition();
 }
 
-Airplane::~Airplane() {
-  if (toDestination) delete toDestination;
-}
+Airplane::Airplane(DecoratorTag tag, const IEntity& wrapped)
+    : IEntity(tag, wrapped) {}
+
+Airplane::~Airplane() {}
 
 void Airplane::update(double dt) {
   // DCM integration
-  DataCollectionManager* dcm = DataCollectionManager::getInstance();
+  DataCollectionManager* dcm = &getContext().getDataCollection();
   dcm->logEvent(this, "timesteps_of_entity", 1.0);
 
   if (toDestination) {
     toDestination->move(this, dt);
 
     // Calculate how far it moved since last frame
-    double diff = this->lastPosition.dist(this->position);
+    double diff = this->lastPosition.dist(this->getPosition());
 
     // Update the position for next time
-    this->lastPosition = this->position;
+    this->lastPosition = this->getPosition();
 
     // Update distance traveled
     this->distanceTraveled += diff;
@@ -42,37 +45,58 @@ void Airplane::update(double dt) {
       dcm->logEvent(this, "reached_dest",
                     1.0);  // counter for when airplane reaches dest
 
-      delete toDestination;
-      toDestination = nullptr;
-
-      Vector3 newDestination;
-      if (position.z > 0) {
-        position.x = ((static_cast<double>(rand())) / RAND_MAX) * (2900) - 1400;
-        position.y = 700;
-        position.z = -800;
-        newDestination.x =
-            ((static_cast<double>(rand())) / RAND_MAX) * (2900) - 1400;
-        newDestination.y = 700;
-        newDestination.z = 800;
-      } else {
-        position.x = ((static_cast<double>(rand())) / RAND_MAX) * (2900) - 1400;
-        position.y = 700;
-        position.z = 800;
-        newDestination.x =
-            ((static_cast<double>(rand())) / RAND_MAX) * (2900) - 1400;
-        newDestination.y = 700;
-        newDestination.z = -800;
-      }
-
-      toDestination = new BeelineStrategy(position, newDestination);
+      toDestination.reset();
+
+      commit([this] {
+        Vector3 position = getPosition();
+        Vector3 newDestination;
+        if (position.z > 0) {
+          position.x = uniform(-1400, 1500);
+          position.y = 700;
+          position.z = -800;
+          newDestination.x = uniform(-1400, 1500);
+          newDestination.y = 700;
+          newDestination.z = 800;
+        } else {
+          position.x = uniform(-1400, 1500);
+          position.y = 700;
+          position.z = 800;
+          newDestination.x = uniform(-1400, 1500);
+          newDestination.y = 700;
+          newDestination.z = -800;
+        }
+
+        setPosition(position);
+        toDestination = getContext().getStrategies().make<BeelineStrategy>(
+            position, newDestination);
+        // the respawn teleports the airplane, so the ATC must re-check it
+        getContext().getATC().routeChanged(getId());
+      });
     }
   } else {
     Vector3 newDestination;
-    if (position.z > 0) {
+    if (getPosition().z > 0) {
       newDestination = Vector3(-1600, 700, 800);
     } else {
       newDestination = Vector3(1600, 700, -800);
     }
-    toDestination = new BeelineStrategy(position, newDestination);
+    toDestination = getContext().getStrategies().make<BeelineStrategy>(
+        getPosition(), newDestination);
   }
 }
+
+void Airplane::save(SnapshotWriter& out) const {
+  IEntity::save(out);
+  out.write(arrived);
+  PathStrategy::save(out, toDestination);
+  out.write(distanceTraveled);
+  out.write(lastPosition);
+}
+
+void Airplane::load(SnapshotReader& in) {
+  IEntity::load(in);
+  arrived = in.read<bool>();
+  toDestination = PathStrategy::load(in, this);
+  distanceTraveled = in.read<double>();
+  lastPosition = in.read<Vector3>();
+}
@@ -1,11 +1,15 @@
 #include "ChargingStation.h"
 
 #include "DataCollectionManager.h"
+#include "SimulationContext.h"
 
 ChargingStation::ChargingStation(const JsonObject& obj) : IEntity(obj) {}
 
 void ChargingStation::update(double dt) {
   // DCM integration
-  DataCollectionManager* dcm = DataCollectionManager::getInstance();
+  DataCollectionManager* dcm = &getContext().getDataCollection();
   dcm->logEvent(this, "timesteps_of_entity", 1.0);
+
+  // stations never change
+  sleep();
 }
@@ -4,6 +4,7 @@
 #include <cmath>
 #include <limits>
 
+#include "ATC.h"
 #include "AstarStrategy.h"
 #include "BeelineStrategy.h"
 #include "BfsStrategy.h"
@@ -11,19 +12,22 @@
 #include "DfsStrategy.h"
 #include "DijkstraStrategy.h"
 #include "Package.h"
+#include "SimulationContext.h"
 #include "SimulationModel.h"
+#include "Snapshot.h"
 
 Drone::Drone(const JsonObject &obj) : IEntity(obj) { available = true; }
 
-Drone::~Drone() {
-  if (toPackage) delete toPackage;
-  if (toFinalDestination) delete toFinalDestination;
+Drone::Drone(DecoratorTag tag, const IEntity &wrapped)
+    : IEntity(tag, wrapped) {
+  available = true;
 }
 
+Drone::~Drone() {}
+
 void Drone::getNextDelivery() {
-  if (model && model->scheduledDeliveries.size() > 0) {
-    package = model->scheduledDeliveries.front();
-    model->scheduledDeliveries.pop_front();
+  if (model) {
+    package = model->takeDelivery();
 
     if (package) {
       std::string message = getName() + " heading to: " + package->getName();
@@ -33,47 +37,68 @@ void Drone::getNextDelivery() {
 
       Vector3 packagePosition = package->getPosition();
       Vector3 finalDestination = package->getDestination();
+      StrategyPool &strategies = getContext().getStrategies();
 
-      toPackage = new BeelineStrategy(position, packagePosition);
+      toPackage =
+          strategies.make<BeelineStrategy>(getPosition(), packagePosition);
 
       std::string strat = package->getStrategyName();
       if (strat == "astar") {
-        toFinalDestination = new AstarStrategy(
+        toFinalDestination = strategies.make<AstarStrategy>(
             packagePosition, finalDestination, model->getGraph());
       } else if (strat == "dfs") {
-        toFinalDestination = new DfsStrategy(packagePosition, finalDestination,
-                                             model->getGraph());
+        toFinalDestination = strategies.make<DfsStrategy>(
+            packagePosition, finalDestination, model->getGraph());
       } else if (strat == "bfs") {
-        toFinalDestination = new BfsStrategy(packagePosition, finalDestination,
-                                             model->getGraph());
+        toFinalDestination = strategies.make<BfsStrategy>(
+            packagePosition, finalDestination, model->getGraph());
       } else if (strat == "dijkstra") {
-        toFinalDestination = new DijkstraStrategy(
+        toFinalDestination = strategies.make<DijkstraStrategy>(
             packagePosition, finalDestination, model->getGraph());
       } else {
         toFinalDestination =
-            new BeelineStrategy(packagePosition, finalDestination);
+            strategies.make<BeelineStrategy>(packagePosition, finalDestination);
       }
+      getContext().getATC().routeChanged(getId());
     }
   }
 }
 
 void Drone::update(double dt) {
   // DCM integration
-  DataCollectionManager *dcm = DataCollectionManager::getInstance();
+  DataCollectionManager *dcm = &getContext().getDataCollection();
   dcm->logEvent(this, "timesteps_of_entity", 1.0);
 
+  // packages only travel along while the drone carries them this tick
+  carry(nullptr);
+
   // Calculate how far it moved since last frame
-  double diff = this->lastPosition.dist(this->position);
+  double diff = this->lastPosition.dist(this->getPosition());
 
   // Update the position for next time
-  this->lastPosition = this->position;
+  this->lastPosition = this->getPosition();
 
   // Update distance traveled
   this->distanceTraveled += diff;
 
   dcm->logEvent(this, "distance_traveled", this->distanceTraveled);
 
-  if (available) getNextDelivery();
+  // a package removed from the simulation ends its trip
+  if ((toPackage || toFinalDestination) && !package) {
+    toPackage.reset();
+    toFinalDestination.reset();
+    available = true;
+    pickedUp = false;
+  }
+
+  // claiming a delivery pops the shared queue; with nothing to claim the
+  // drone sleeps until a delivery is scheduled
+  if (available) {
+    commit([this] {
+      getNextDelivery();
+      if (available && model) model->awaitDelivery(getId());
+    });
+  }
 
   if (toPackage) {
     toPackage->move(this, dt);
@@ -81,24 +106,19 @@ void Drone::update(double dt) {
     if (toPackage->isCompleted()) {
       std::string message = getName() + " picked up: " + package->getName();
       notifyObservers(message);
-      delete toPackage;
-      toPackage = nullptr;
+      toPackage.reset();
       pickedUp = true;
     }
   } else if (toFinalDestination) {
     toFinalDestination->move(this, dt);
 
-    if (package && pickedUp) {
-      package->setPosition(position);
-      package->setDirection(direction);
-    }
+    if (package && pickedUp) carry(package);
 
     if (toFinalDestination->isCompleted()) {
       std::string message = getName() + " dropped off: " + package->getName();
       notifyObservers(message);
-      delete toFinalDestination;
-      toFinalDestination = nullptr;
-      package->handOff();
+      toFinalDestination.reset();
+      commit([package = package] { package->handOff(); });
       package = nullptr;
       available = true;
       pickedUp = false;
@@ -108,6 +128,47 @@ void Drone::update(double dt) {
     }
   }
 }
+void Drone::fastForward(double /*seconds*/, long ticks) {
+  // an idle drone logs its unchanged distance once per tick
+  getContext().getDataCollection().logEvent(
+      this, "distance_traveled", this->distanceTraveled * ticks);
+}
+
+void Drone::carry(Package *package) {
+  store().carrying(getId()) = package ? package->getId() : -1;
+  if (package && package->isAsleep()) package->wake();
+}
+
 Package *Drone::getPackage() { return package; };
 
 void Drone::setPackage(Package *p) { package = p; }
+
+void Drone::save(SnapshotWriter &out) const {
+  saveShared(out);
+  out.write(available);
+  out.write(pickedUp);
+  PathStrategy::save(out, toPackage);
+  PathStrategy::save(out, toFinalDestination);
+  out.write(distanceTraveled);
+  out.write(lastPosition);
+}
+
+void Drone::load(SnapshotReader &in) {
+  loadShared(in);
+  available = in.read<bool>();
+  pickedUp = in.read<bool>();
+  toPackage = PathStrategy::load(in, this);
+  toFinalDestination = PathStrategy::load(in, this);
+  distanceTraveled = in.read<double>();
+  lastPosition = in.read<Vector3>();
+}
+
+void Drone::saveShared(SnapshotWriter &out) const {
+  IEntity::save(out);
+  out.write(package ? package->getId() : -1);
+}
+
+void Drone::loadShared(SnapshotReader &in) {
+  IEntity::load(in);
+  package = dynamic_cast<Package *>(model->getEntity(in.read<int>()));
+}
@@ -0,0 +1,81 @@
+#include "EntityRegistry.h"
+
+#include "IEntity.h"
+
+namespace {
+// type an entity was created as, empty if its details have none
+std::string typeOf(const IEntity* entity) {
+  const JsonObject& details = entity->getDetails();
+  return details.contains("type") ? std::string(details["type"]) : "";
+}
+
+// drop an id from an index, along with its key once no id is left
+void unindex(std::unordered_map<std::string, std::set<int>>& index,
+             const std::string& key, int id) {
+  auto it = index.find(key);
+  if (it == index.end()) return;
+  it->second.erase(id);
+  if (it->second.empty()) index.erase(it);
+}
+
+const std::set<int> none;
+}  // namespace
+
+EntityRegistry::Handle EntityRegistry::add(IEntity* entity) {
+  int id = entity->getId();
+  if (id < 0) return Handle();
+  if (const Handle* known = handles.get(id)) return *known;
+  Handle handle = entities.insert(entity);
+  handles.insert(id, handle);
+  names[entity->getName()].insert(id);
+  types[typeOf(entity)].insert(id);
+  return handle;
+}
+
+bool EntityRegistry::remove(int id) {
+  IEntity* entity = get(id);
+  if (!entity) return false;
+  unindex(names, entity->getName(), id);
+  unindex(types, typeOf(entity), id);
+  bool erased = entities.erase(*handles.get(id));
+  handles.erase(id);
+  return erased;
+}
+
+const std::set<int>& EntityRegistry::named(const std::string& name) const {
+  auto it = names.find(name);
+  return it != names.end() ? it->second : none;
+}
+
+const std::set<int>& EntityRegistry::ofType(const std::string& type) const {
+  auto it = types.find(type);
+  return it != types.end() ? it->second : none;
+}
+
+IEntity* EntityRegistry::get(int id) const { return get(handle(id)); }
+
+IEntity* EntityRegistry::get(Handle handle) const {
+  IEntity* const* entity = entities.get(handle);
+  return entity ? *entity : nullptr;
+}
+
+EntityRegistry::Handle EntityRegistry::handle(int id) const {
+  const Handle* known = handles.get(id);
+  return known ? *known : Handle();
+}
+
+bool EntityRegistry::contains(Handle handle) const {
+  return entities.contains(handle);
+}
+
+size_t EntityRegistry::size() const { return entities.size(); }
+
+bool EntityRegistry::empty() const { return entities.empty(); }
+
+std::vector<IEntity*>::const_iterator EntityRegistry::begin() const {
+  return entities.begin();
+}
+
+std::vector<IEntity*>::const_iterator EntityRegistry::end() const {
+  return entities.end();
+}
@@ -0,0 +1,122 @@
+#include "EntityStore.h"
+
+namespace {
+// rebuild a column so that row r holds what row from[r] held
+template <typename T>
+void permute(std::vector<T>& column, const std::vector<size_t>& from) {
+  std::vector<T> arranged;
+  arranged.reserve(column.size());
+  for (size_t row : from) arranged.push_back(column[row]);
+  column.swap(arranged);
+}
+}  // namespace
+
+void EntityStore::add(int id) {
+  if (!rows.insert(id, ids.size())) return;
+
+  ids.push_back(id);
+  positions.emplace_back();
+  directions.emplace_back();
+  speeds.push_back(0);
+  batteries.push_back(0);
+  carried.push_back(-1);
+  deliveries.push_back(DeliveryState::Unscheduled);
+  walkers.push_back(0);
+  walkDirections.emplace_back();
+  walkLengths.push_back(0);
+  walkSteps.emplace_back();
+}
+
+void EntityStore::remove(int id) {
+  if (!contains(id)) return;
+
+  size_t row = *rows.get(id);
+  size_t last = ids.size() - 1;
+  if (row != last) {
+    // move the last row into the hole
+    ids[row] = ids[last];
+    positions[row] = positions[last];
+    directions[row] = directions[last];
+    speeds[row] = speeds[last];
+    batteries[row] = batteries[last];
+    carried[row] = carried[last];
+    deliveries[row] = deliveries[last];
+    walkers[row] = walkers[last];
+    walkDirections[row] = walkDirections[last];
+    walkLengths[row] = walkLengths[last];
+    walkSteps[row] = walkSteps[last];
+    *rows.get(ids[row]) = row;
+  }
+  ids.pop_back();
+  positions.pop_back();
+  directions.pop_back();
+  speeds.pop_back();
+  batteries.pop_back();
+  carried.pop_back();
+  deliveries.pop_back();
+  walkers.pop_back();
+  walkDirections.pop_back();
+  walkLengths.pop_back();
+  walkSteps.pop_back();
+  rows.erase(id);
+}
+
+bool EntityStore::contains(int id) const {
+  return rows.contains(id);
+}
+
+size_t EntityStore::size() const { return ids.size(); }
+
+void EntityStore::arrange(const std::vector<int>& order) {
+  std::vector<size_t> from;
+  from.reserve(ids.size());
+  std::vector<bool> placed(ids.size(), false);
+  for (int id : order) {
+    const size_t* row = rows.get(id);
+    if (!row || placed[*row]) continue;
+    from.push_back(*row);
+    placed[*row] = true;
+  }
+  for (size_t row = 0; row < ids.size(); ++row) {
+    if (!placed[row]) from.push_back(row);
+  }
+
+  permute(ids, from);
+  permute(positions, from);
+  permute(directions, from);
+  permute(speeds, from);
+  permute(batteries, from);
+  permute(carried, from);
+  permute(deliveries, from);
+  permute(walkers, from);
+  permute(walkDirections, from);
+  permute(walkLengths, from);
+  permute(walkSteps, from);
+  for (size_t row = 0; row < ids.size(); ++row) *rows.get(ids[row]) = row;
+}
+
+void EntityStore::followCarriers() {
+  for (size_t row = 0; row < carried.size(); ++row) {
+    const size_t* package = rows.get(carried[row]);
+    if (!package) continue;
+    positions[*package] = positions[row];
+    directions[*package] = directions[row];
+  }
+}
+
+void EntityStore::walkPaths(double dt) {
+  walkedDt = dt;
+  size_t count = positions.size();
+  const Vector3* position = positions.data();
+  const Vector3* direction = walkDirections.data();
+  const double* speed = speeds.data();
+  Vector3* step = walkSteps.data();
+  // no branches: rows that walk nothing have a zero direction and stay put,
+  // so the loop vectorizes
+  for (size_t row = 0; row < count; ++row) {
+    double distance = speed[row] * dt;
+    step[row].x = position[row].x + direction[row].x * distance;
+    step[row].y = position[row].y + direction[row].y * distance;
+    step[row].z = position[row].z + direction[row].z * distance;
+  }
+}
@@ -4,30 +4,34 @@
 #include <cmath>
 #include <limits>
 
+#include "ATC.h"
 #include "BeelineStrategy.h"
 #include "DataCollectionManager.h"
+#include "SimulationContext.h"
+#include "Snapshot.h"
 
 Helicopter::Helicopter(const JsonObject& obj) : IEntity(obj) {
-  this->lastPosition = this->position;
+  this->lastPosition = this->getPosition();
 }
 
-Helicopter::~Helicopter() {
-  if (movement) delete movement;
-}
+Helicopter::Helicopter(DecoratorTag tag, const IEntity& wrapped)
+    : IEntity(tag, wrapped) {}
+
+Helicopter::~Helicopter() {}
 
 void Helicopter::update(double dt) {
   // DCM integration
-  DataCollectionManager* dcm = DataCollectionManager::getInstance();
+  DataCollectionManager* dcm = &getContext().getDataCollection();
   dcm->logEvent(this, "timesteps_of_entity", 1);
 
   if (movement && !movement->isCompleted()) {
     movement->move(this, dt);
 
     // Calculate how far it moved since last frame
-    double diff = this->lastPosition.dist(this->position);
+    double diff = this->lastPosition.dist(this->getPosition());
 
     // Update the position for next time
-    this->lastPosition = this->position;
+    this->lastPosition = this->getPosition();
 
     // Update distance traveled
     this->distanceTraveled += diff;
@@ -45,11 +49,31 @@ void Helicopter::update(double dt) {
       this->distanceTraveled = 0;
     }
   } else {
-    if (movement) delete movement;
-    Vector3 dest;
-    dest.x = ((static_cast<double>(rand())) / RAND_MAX) * (2900) - 1400;
-    dest.y = position.y;
-    dest.z = ((static_cast<double>(rand())) / RAND_MAX) * (1600) - 800;
-    movement = new BeelineStrategy(position, dest);
+    commit([this] {
+      movement.reset();
+      Vector3 dest;
+      dest.x = uniform(-1400, 1500);
+      dest.y = getPosition().y;
+      dest.z = uniform(-800, 800);
+      movement = getContext().getStrategies().make<BeelineStrategy>(
+          getPosition(), dest);
+      getContext().getATC().routeChanged(getId());
+    });
   }
 }
+
+void Helicopter::save(SnapshotWriter& out) const {
+  IEntity::save(out);
+  PathStrategy::save(out, movement);
+  out.write(distanceTraveled);
+  out.write(mileCounter);
+  out.write(lastPosition);
+}
+
+void Helicopter::load(SnapshotReader& in) {
+  IEntity::load(in);
+  movement = PathStrategy::load(in, this);
+  distanceTraveled = in.read<double>();
+  mileCounter = in.read<unsigned int>();
+  lastPosition = in.read<Vector3>();
+}
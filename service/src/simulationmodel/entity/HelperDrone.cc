@@ -4,6 +4,7 @@
 #include <cmath>
 #include <limits>
 
+#include "ATC.h"
 #include "AstarStrategy.h"
 #include "BeelineStrategy.h"
 #include "BfsStrategy.h"
@@ -13,19 +14,19 @@
 #include "Drone.h"
 #include "LeaderDrone.h"
 #include "Package.h"
+#include "SimulationContext.h"
 #include "SimulationModel.h"
+#include "Snapshot.h"
 
 HelperDrone::HelperDrone(const JsonObject& obj) : Drone(obj) {
   available = true;
 }
 // adding somecomment to help test
-HelperDrone::~HelperDrone() {
-  if (toPackage) delete toPackage;
-  if (toFinalDestination) delete toFinalDestination;
-}
+HelperDrone::~HelperDrone() {}
 
 void HelperDrone::getNextDelivery(Package* leader_package) {
   Drone::setPackage(leader_package);
+  wake();
 
   Package* package = getPackage();
 
@@ -38,39 +39,45 @@ void HelperDrone::getNextDelivery(Package* leader_package) {
 
       Vector3 packagePosition = package->getPosition();
       Vector3 finalDestination = package->getDestination();
+      StrategyPool &strategies = getContext().getStrategies();
 
-      toPackage = new BeelineStrategy(position, packagePosition);
+      toPackage =
+          strategies.make<BeelineStrategy>(getPosition(), packagePosition);
 
       std::string strat = package->getStrategyName();
       if (strat == "astar") {
-        toFinalDestination = new AstarStrategy(
+        toFinalDestination = strategies.make<AstarStrategy>(
             packagePosition, finalDestination, model->getGraph());
       } else if (strat == "dfs") {
-        toFinalDestination = new DfsStrategy(packagePosition, finalDestination,
-                                             model->getGraph());
+        toFinalDestination = strategies.make<DfsStrategy>(
+            packagePosition, finalDestination, model->getGraph());
       } else if (strat == "bfs") {
-        toFinalDestination = new BfsStrategy(packagePosition, finalDestination,
-                                             model->getGraph());
+        toFinalDestination = strategies.make<BfsStrategy>(
+            packagePosition, finalDestination, model->getGraph());
       } else if (strat == "dijkstra") {
-        toFinalDestination = new DijkstraStrategy(
+        toFinalDestination = strategies.make<DijkstraStrategy>(
             packagePosition, finalDestination, model->getGraph());
       } else {
         toFinalDestination =
-            new BeelineStrategy(packagePosition, finalDestination);
+            strategies.make<BeelineStrategy>(packagePosition, finalDestination);
       }
+      getContext().getATC().routeChanged(getId());
     }
   }
 }
 
 void HelperDrone::update(double dt) {
   // DCM integration
-  DataCollectionManager* dcm = DataCollectionManager::getInstance();
+  DataCollectionManager* dcm = &getContext().getDataCollection();
   dcm->logEvent(this, "timesteps_of_entity", 1.0);
+  // packages only travel along while the drone carries them this tick
+  carry(nullptr);
+
   // Calculate how far it moved since last frame
-  double diff = this->lastPosition.dist(this->position);
+  double diff = this->lastPosition.dist(this->getPosition());
 
   // Update the position for next time
-  this->lastPosition = this->position;
+  this->lastPosition = this->getPosition();
 
   // Update distance traveled
   this->distanceTraveled += diff;
@@ -81,23 +88,26 @@ void HelperDrone::update(double dt) {
   //      getNextDelivery();
   // } we wait so this code no longer needed
   Package* package = getPackage();
+  // a package removed from the simulation ends its trip
+  if ((toPackage || toFinalDestination) && !package) {
+    toPackage.reset();
+    toFinalDestination.reset();
+    available = true;
+    pickedUp = false;
+  }
   if (toPackage) {
     toPackage->move(this, dt);
 
     if (toPackage->isCompleted()) {
       std::string message = getName() + " picked up: " + package->getName();
       notifyObservers(message);
-      delete toPackage;
-      toPackage = nullptr;
+      toPackage.reset();
       pickedUp = true;
     }
   } else if (toFinalDestination) {
     toFinalDestination->move(this, dt);
 
-    if (package && pickedUp) {
-      package->setPosition(position);
-      package->setDirection(direction);
-    }
+    if (package && pickedUp) carry(package);
 
     if (toFinalDestination->isCompleted()) {
       std::string message = getName() + " dropped off: " + package->getName();
@@ -105,16 +115,23 @@ void HelperDrone::update(double dt) {
       dcm->logEvent(this, "packages_delivered", 1.0);
 
       notifyObservers(message);
-      delete toFinalDestination;
-      toFinalDestination = nullptr;
-      package->handOff();
+      toFinalDestination.reset();
+      commit([package] { package->handOff(); });
       Drone::setPackage(nullptr);
       available = true;
       pickedUp = false;
     }
+  } else {
+    // idle until a leader hands off a package
+    sleep();
   }
 }
 
+void HelperDrone::fastForward(double /*seconds*/, long ticks) {
+  getContext().getDataCollection().logEvent(
+      this, "distance_traveled", this->distanceTraveled * ticks);
+}
+
 void HelperDrone::notify(const std::string& message) const {
   model->notify(message);
 }
@@ -149,3 +166,24 @@ void HelperDrone::notifyWithPublisher(const std::string& message,
 }
 
 Package* HelperDrone::getPackage() { return Drone::getPackage(); };
+
+void HelperDrone::save(SnapshotWriter& out) const {
+  // the delivery state lives in this class's own members
+  saveShared(out);
+  out.write(available);
+  out.write(pickedUp);
+  PathStrategy::save(out, toPackage);
+  PathStrategy::save(out, toFinalDestination);
+  out.write(distanceTraveled);
+  out.write(lastPosition);
+}
+
+void HelperDrone::load(SnapshotReader& in) {
+  loadShared(in);
+  available = in.read<bool>();
+  pickedUp = in.read<bool>();
+  toPackage = PathStrategy::load(in, this);
+  toFinalDestination = PathStrategy::load(in, this);
+  distanceTraveled = in.read<double>();
+  lastPosition = in.read<Vector3>();
+}
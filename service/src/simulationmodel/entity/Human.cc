@@ -6,36 +6,36 @@
 
 #include "AstarStrategy.h"
 #include "DataCollectionManager.h"
+#include "SimulationContext.h"
 #include "SimulationModel.h"
+#include "Snapshot.h"
 
 Vector3 Human::kellerPosition(64.0, 254.0, -210.0);
 
 Human::Human(const JsonObject& obj) : IEntity(obj) {}
 
-Human::~Human() {
-  if (movement) delete movement;
-}
+Human::~Human() {}
 
 void Human::update(double dt) {
   // DCM integration
-  DataCollectionManager* dcm = DataCollectionManager::getInstance();
+  DataCollectionManager* dcm = &getContext().getDataCollection();
   dcm->logEvent(this, "timesteps_of_entity", 1.0);
 
   if (movement && !movement->isCompleted()) {
     movement->move(this, dt);
 
     // Calculate how far it moved since last frame
-    double diff = this->lastPosition.dist(this->position);
+    double diff = this->lastPosition.dist(this->getPosition());
 
     // Update the position for next time
-    this->lastPosition = this->position;
+    this->lastPosition = this->getPosition();
 
     // Update distance traveled
     this->distanceTraveled += diff;
 
     dcm->logEvent(this, "distance_traveled", this->distanceTraveled);
 
-    bool nearKeller = this->position.dist(Human::kellerPosition) < 85;
+    bool nearKeller = this->getPosition().dist(Human::kellerPosition) < 85;
     if (nearKeller && !this->atKeller) {
       std::string message = this->getName() + " visited Keller hall";
       notifyObservers(message);
@@ -44,11 +44,32 @@ void Human::update(double dt) {
     }
     atKeller = nearKeller;
   } else {
-    if (movement) delete movement;
-    Vector3 dest;
-    dest.x = ((static_cast<double>(rand())) / RAND_MAX) * (2900) - 1400;
-    dest.y = position.y;
-    dest.z = ((static_cast<double>(rand())) / RAND_MAX) * (1600) - 800;
-    if (model) movement = new AstarStrategy(position, dest, model->getGraph());
+    commit([this] {
+      movement.reset();
+      Vector3 dest;
+      dest.x = uniform(-1400, 1500);
+      dest.y = getPosition().y;
+      dest.z = uniform(-800, 800);
+      if (model) {
+        movement = getContext().getStrategies().make<AstarStrategy>(
+            getPosition(), dest, model->getGraph());
+      }
+    });
   }
 }
+
+void Human::save(SnapshotWriter& out) const {
+  IEntity::save(out);
+  PathStrategy::save(out, movement);
+  out.write(atKeller);
+  out.write(distanceTraveled);
+  out.write(lastPosition);
+}
+
+void Human::load(SnapshotReader& in) {
+  IEntity::load(in);
+  movement = PathStrategy::load(in, this);
+  atKeller = in.read<bool>();
+  distanceTraveled = in.read<double>();
+  lastPosition = in.read<Vector3>();
+}
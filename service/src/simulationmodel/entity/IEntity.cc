@@ -1,37 +1,69 @@
 #include "IEntity.h"
 
-#include "DataCollectionManager.h"
+#include <sstream>
 
-IEntity::IEntity() {
-  static int currentId = 0;
-  id = currentId;
-  currentId++;
+#include "DataCollectionManager.h"
+#include "SimulationContext.h"
+#include "SimulationModel.h"
+#include "Snapshot.h"
+
+thread_local std::vector<std::function<void()>>* IEntity::deferredEffects =
+    nullptr;
+
+IEntity::IEntity() : context(&SimulationContext::current()) {
+  id = context->nextId();
+  std::seed_seq seed{context->getSeed(), static_cast<unsigned>(id)};
+  random.seed(seed);
+  // kinematic state lives in the entity store
+  store().add(id);
 }
 
 IEntity::IEntity(const JsonObject& details) : IEntity() {
   this->details = details;
+  EntityStore& store = this->store();
   JsonArray pos(details["position"]);
-  position = {pos[0], pos[1], pos[2]};
+  store.position(id) = {pos[0], pos[1], pos[2]};
   JsonArray dir(details["direction"]);
-  direction = {dir[0], dir[1], dir[2]};
+  store.direction(id) = {dir[0], dir[1], dir[2]};
   if (details.contains("color")) {
     std::string col = details["color"];
     color = col;
   }
   std::string n = details["name"];
   name = n;
-  speed = details["speed"];
+  store.speed(id) = details["speed"];
 }
 
-IEntity::~IEntity() {}
+IEntity::IEntity(DecoratorTag, const IEntity& wrapped)
+    : context(wrapped.context), id(wrapped.id), ownsRow(false) {}
+
+IEntity::~IEntity() {
+  if (ownsRow) store().remove(id);
+}
 
 void IEntity::linkModel(SimulationModel* model) { this->model = model; }
 
 int IEntity::getId() const { return id; }
 
-Vector3 IEntity::getPosition() const { return position; }
+SimulationContext& IEntity::getContext() const { return *context; }
+
+EntityStore& IEntity::store() const { return context->getStore(); }
+
+const EntityRegistry& IEntity::registry() const {
+  return context->getEntities();
+}
+
+double IEntity::uniform(double low, double high) {
+  return std::uniform_real_distribution<double>(low, high)(random);
+}
+
+Vector3 IEntity::getPosition() const {
+  return store().position(id);
+}
 
-Vector3 IEntity::getDirection() const { return direction; }
+Vector3 IEntity::getDirection() const {
+  return store().direction(id);
+}
 
 const JsonObject& IEntity::getDetails() const { return details; }
 
@@ -39,16 +71,88 @@ std::string IEntity::getColor() const { return color; }
 
 std::string IEntity::getName() const { return name; }
 
-double IEntity::getSpeed() const { return speed; }
+double IEntity::getSpeed() const {
+  return store().speed(id);
+}
 
-void IEntity::setPosition(Vector3 pos_) { position = pos_; }
+void IEntity::setPosition(Vector3 pos_) {
+  store().position(id) = pos_;
+}
 
-void IEntity::setDirection(Vector3 dir_) { direction = dir_; }
+void IEntity::setDirection(Vector3 dir_) {
+  store().direction(id) = dir_;
+}
 
 void IEntity::setColor(std::string col_) { color = col_; }
 
 void IEntity::rotate(double angle) {
+  Vector3& direction = store().direction(id);
   Vector3 dirTmp = direction;
   direction.x = dirTmp.x * std::cos(angle) - dirTmp.z * std::sin(angle);
   direction.z = dirTmp.x * std::sin(angle) + dirTmp.z * std::cos(angle);
 }
+
+void IEntity::notifyObservers(const std::string& message) {
+  commit([this, message] { IPublisher::notifyObservers(message); });
+}
+
+void IEntity::commit(std::function<void()> effect) {
+  if (deferredEffects) {
+    deferredEffects->push_back(std::move(effect));
+  } else {
+    effect();
+  }
+}
+
+void IEntity::deferEffects(std::vector<std::function<void()>>* effects) {
+  deferredEffects = effects;
+}
+
+void IEntity::sleep() {
+  commit([this] {
+    if (model) model->sleepEntity(id);
+  });
+}
+
+void IEntity::sleepUntil(double time) {
+  commit([this, time] {
+    if (model) model->sleepEntity(id, time);
+  });
+}
+
+void IEntity::wake() {
+  commit([this] {
+    if (model) model->wakeEntity(id);
+  });
+}
+
+bool IEntity::isAsleep() const { return model && model->isAsleep(id); }
+
+void IEntity::save(SnapshotWriter& out) const {
+  EntityStore& store = this->store();
+  size_t row = store.row(id);
+  out.write(store.positions[row]);
+  out.write(store.directions[row]);
+  out.write(store.speeds[row]);
+  out.write(store.batteries[row]);
+  out.write(store.carried[row]);
+  out.write(store.deliveries[row]);
+  out.write(color);
+  std::ostringstream state;
+  state << random;
+  out.write(state.str());
+}
+
+void IEntity::load(SnapshotReader& in) {
+  EntityStore& store = this->store();
+  size_t row = store.row(id);
+  store.positions[row] = in.read<Vector3>();
+  store.directions[row] = in.read<Vector3>();
+  store.speeds[row] = in.read<double>();
+  store.batteries[row] = in.read<double>();
+  store.carried[row] = in.read<int>();
+  store.deliveries[row] = in.read<EntityStore::DeliveryState>();
+  color = in.readString();
+  std::istringstream state(in.readString());
+  state >> random;
+}
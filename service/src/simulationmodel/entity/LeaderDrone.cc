@@ -4,29 +4,29 @@
 #include <cmath>
 #include <iostream>  //used to move drone to random location after charging
 
+#include "ATC.h"
 #include "AstarStrategy.h"
 #include "BeelineStrategy.h"
 #include "BfsStrategy.h"
 #include "DataCollectionManager.h"
 #include "DfsStrategy.h"
 #include "DijkstraStrategy.h"
+#include "Log.h"
 #include "Package.h"
+#include "SimulationContext.h"
 #include "SimulationModel.h"
+#include "Snapshot.h"
 
 LeaderDrone::LeaderDrone(const JsonObject &obj) : Drone(obj) {
   available = true;
+  battery() = max_battery_health;
 }
 
-LeaderDrone::~LeaderDrone() {
-  if (toPackage) delete toPackage;
-  if (toFinalDestination) delete toFinalDestination;
-  if (toChargingStation) delete toChargingStation;
-}
+LeaderDrone::~LeaderDrone() {}
 
 void LeaderDrone::getNextDelivery() {
-  if (model && model->scheduledDeliveries.size() > 0) {
-    Drone::setPackage(model->scheduledDeliveries.front());
-    model->scheduledDeliveries.pop_front();
+  if (model) {
+    Drone::setPackage(model->takeDelivery());
 
     Package *package = getPackage();
 
@@ -38,63 +38,127 @@ void LeaderDrone::getNextDelivery() {
 
       Vector3 packagePosition = package->getPosition();
       Vector3 finalDestination = package->getDestination();
+      StrategyPool &strategies = getContext().getStrategies();
 
-      toPackage = new BeelineStrategy(position, packagePosition);
+      toPackage =
+          strategies.make<BeelineStrategy>(getPosition(), packagePosition);
 
       std::string strat = package->getStrategyName();
       if (strat == "astar") {
-        toFinalDestination = new AstarStrategy(
+        toFinalDestination = strategies.make<AstarStrategy>(
             packagePosition, finalDestination, model->getGraph());
       } else if (strat == "dfs") {
-        toFinalDestination = new DfsStrategy(packagePosition, finalDestination,
-                                             model->getGraph());
+        toFinalDestination = strategies.make<DfsStrategy>(
+            packagePosition, finalDestination, model->getGraph());
       } else if (strat == "bfs") {
-        toFinalDestination = new BfsStrategy(packagePosition, finalDestination,
-                                             model->getGraph());
+        toFinalDestination = strategies.make<BfsStrategy>(
+            packagePosition, finalDestination, model->getGraph());
       } else if (strat == "dijkstra") {
-        toFinalDestination = new DijkstraStrategy(
+        toFinalDestination = strategies.make<DijkstraStrategy>(
             packagePosition, finalDestination, model->getGraph());
       } else {
         toFinalDestination =
-            new BeelineStrategy(packagePosition, finalDestination);
+            strategies.make<BeelineStrategy>(packagePosition, finalDestination);
       }
+      getContext().getATC().routeChanged(getId());
     }
   }
 }
 
-double LeaderDrone::getBatteryHealth() { return battery_health; }
+void LeaderDrone::fastForward(double seconds, long ticks) {
+  depleteBattery(seconds);
+  getContext().getDataCollection().logEvent(
+      this, "distance_traveled", this->distanceTraveled * ticks);
+}
+
+void LeaderDrone::save(SnapshotWriter &out) const {
+  // the delivery state lives in this class's own members
+  saveShared(out);
+  out.write(available);
+  out.write(pickedUp);
+  PathStrategy::save(out, toPackage);
+  PathStrategy::save(out, toFinalDestination);
+  PathStrategy::save(out, toChargingStation);
+  std::uint64_t responses = 0;
+  for (const auto &[id, response] : handoffResponses) {
+    if (response.helper) ++responses;
+  }
+  out.write(responses);
+  for (const auto &[id, response] : handoffResponses) {
+    if (!response.helper) continue;
+    out.write(id);
+    out.write(response.distance);
+  }
+  out.write(distanceTraveled);
+  out.write(lastPosition);
+}
+
+void LeaderDrone::load(SnapshotReader &in) {
+  loadShared(in);
+  available = in.read<bool>();
+  pickedUp = in.read<bool>();
+  toPackage = PathStrategy::load(in, this);
+  toFinalDestination = PathStrategy::load(in, this);
+  toChargingStation = PathStrategy::load(in, this);
+  handoffResponses.clear();
+  std::uint64_t responses = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < responses; ++i) {
+    HelperDrone *helper =
+        dynamic_cast<HelperDrone *>(model->getDrone(in.read<int>()));
+    double distance = in.read<double>();
+    if (helper) handoffResponses[helper->getId()] = {helper, distance};
+  }
+  distanceTraveled = in.read<double>();
+  lastPosition = in.read<Vector3>();
+}
+
+double LeaderDrone::getBatteryHealth() { return battery(); }
+
+double &LeaderDrone::battery() {
+  return store().battery(getId());
+}
+
 void LeaderDrone::travelToCharger() {
   Vector3 dronePosition = this->getPosition();
-  toChargingStation =
-      new BeelineStrategy(dronePosition, charging_station_location);
+  toChargingStation = getContext().getStrategies().make<BeelineStrategy>(
+      dronePosition, charging_station_location);
+  commit([this] { getContext().getATC().routeChanged(getId()); });
 }
 
 void LeaderDrone::depleteBattery(double dt) {
-  battery_health = battery_health - .01 * (dt);
-  if (battery_health < 0) {
-    battery_health = 0;
+  bool wasAboveCritical = battery() > critical_battery_health;
+  battery() = battery() - battery_drain * (dt);
+  if (battery() < 0) {
+    battery() = 0;
+  }
+  // once per crossing, not on every tick spent below it
+  if (wasAboveCritical && battery() <= critical_battery_health) {
+    LOG_DEBUG(getName() << " Battery CRITICAL");
   }
 }
 void LeaderDrone::chargeBattery(double dt) {
-  while (battery_health < max_battery_health) {
-    battery_health = battery_health + 0.01 * (dt);
+  while (battery() < max_battery_health) {
+    battery() = battery() + 0.01 * (dt);
   }
 
-  if (battery_health > max_battery_health) {
-    battery_health = max_battery_health;
+  if (battery() > max_battery_health) {
+    battery() = max_battery_health;
   }
 }
 
 void LeaderDrone::update(double dt) {  // setup pointer to current package
   Package *package = Drone::getPackage();
   // DCM integration
-  DataCollectionManager *dcm = DataCollectionManager::getInstance();
+  DataCollectionManager *dcm = &getContext().getDataCollection();
   dcm->logEvent(this, "timesteps_of_entity", 1.0);
+  // packages only travel along while the drone carries them this tick
+  carry(nullptr);
+
   // Calculate how far it moved since last frame
-  double diff = this->lastPosition.dist(this->position);
+  double diff = this->lastPosition.dist(this->getPosition());
 
   // Update the position for next time
-  this->lastPosition = this->position;
+  this->lastPosition = this->getPosition();
 
   // Update distance traveled
   this->distanceTraveled += diff;
@@ -102,39 +166,54 @@ void LeaderDrone::update(double dt) {  // setup pointer to current package
   dcm->logEvent(this, "distance_traveled", this->distanceTraveled);
 
   depleteBattery(dt);
+
+  // a package removed from the simulation ends its trip
+  if ((toPackage || toFinalDestination) && !package) {
+    toPackage.reset();
+    toFinalDestination.reset();
+    pickedUp = false;
+    if (!toChargingStation) available = true;
+  }
   // std::cout <<"DEBUG:"<<getName()<< " battery_health:
   // "<<battery_health<<std::endl;
 
-  if (available && (battery_health > critical_battery_health)) {
-    getNextDelivery();
+  if (available && (battery() > critical_battery_health)) {
+    // claiming a delivery pops the shared queue; with nothing to claim the
+    // drone sleeps until a delivery is scheduled or the battery runs low
+    commit([this] {
+      getNextDelivery();
+      if (available && model) {
+        double critical = model->getTime() +
+                          (battery() - critical_battery_health) / battery_drain;
+        model->awaitDelivery(getId(), critical);
+      }
+    });
   }
 
-  if (available && (battery_health <= critical_battery_health) && !pickedUp) {
+  if (available && (battery() <= critical_battery_health) && !pickedUp) {
     available = false;
     this->travelToCharger();
   }
 
   if (toPackage &&
-      (battery_health > critical_battery_health)) {  // going to package
+      (battery() > critical_battery_health)) {  // going to package
     toPackage->move(this, dt);
 
     if (toPackage->isCompleted()) {
       std::string message = getName() + " picked up: " + package->getName();
-      package->isPickedUp();
+      commit([package] { package->isPickedUp(); });
       notifyObservers(message);
-      delete toPackage;
-      toPackage = nullptr;
+      toPackage.reset();
       pickedUp = true;
     }
-  } else if (toFinalDestination && (battery_health > critical_battery_health) &&
+  } else if (toFinalDestination && (battery() > critical_battery_health) &&
              pickedUp) {
     toFinalDestination->move(this, dt);
 
     if (package && pickedUp) {
       // deplete faster when carrying a package
       depleteBattery(dt);
-      package->setPosition(position);
-      package->setDirection(direction);
+      carry(package);
     }
 
     if (toFinalDestination->isCompleted()) {
@@ -144,24 +223,21 @@ void LeaderDrone::update(double dt) {  // setup pointer to current package
 
       dcm->logEvent(this, "packages_delivered", 1.0);
 
-      delete toFinalDestination;
-      toFinalDestination = nullptr;
-      package->handOff();
-      package->DeliveredPackage();
+      toFinalDestination.reset();
+      commit([package] {
+        package->handOff();
+        package->DeliveredPackage();
+      });
       Drone::setPackage(nullptr);
       available = true;
       pickedUp = false;
     }
   } else if (toChargingStation) {
     toChargingStation->move(this, dt);
-    if (package && pickedUp) {
-      package->setPosition(position);
-      package->setDirection(direction);
-    }
+    if (package && pickedUp) carry(package);
 
     if (toChargingStation->isCompleted()) {
-      delete toChargingStation;
-      toChargingStation = nullptr;
+      toChargingStation.reset();
       chargeBattery(dt);
       if (!pickedUp) {
         available = true;
@@ -187,65 +263,71 @@ void LeaderDrone::update(double dt) {  // setup pointer to current package
                   }
   additional prompts: does it capture the right combinations
   */
-  else if (battery_health <= critical_battery_health) {
+  else if (battery() <= critical_battery_health) {
     // when the battery is equal to or below critical, set availability to
     // false, so it doesn't go pick up a package
     available = false;
-    std::cout << getName() << "DEBUG: Battery CRITICAL\n";
 
     // if carrying a package
     if (package && pickedUp) {
-      if (battery_health > emergency_battery_health) {
-        std::string message = getName() + " requesting handoff";
-        notifyHelperDroneObservers(message);
+      if (battery() > emergency_battery_health) {
         // DCM Integration: Log how many times requests assistence
         dcm->logEvent(this, "handoff_requests", 1.0);
 
-        HelperDrone *helper_drone = nullptr;
-        helper_drone = selectClosestHelperDrone();
-        if (helper_drone != nullptr) {
-          std::string helper_name = helper_drone->getName();
-          std::string leader_name = this->getName();
-
-          std::string message2 =
-              helper_name + " accepted handoff for " + leader_name;
-          dcm->logEvent(helper_drone, "handoff_accepts", 1.0);
-
-          helper_drone->notify(message2);
-
-          // Handoff the package safely
-          helper_drone->getNextDelivery(this->getPackage());
-
-          Drone::setPackage(nullptr);
-        } else {
-          // package not handed off and leader not abandoning package
-          std::string message3 =
-              getName() +
-              "requesting handoff again, no helper drones available";
-          notifyHelperDroneObservers(message3);
-        }
+        // the helpers answer and take over the package, so the whole handoff
+        // runs in the commit phase
+        commit([this, dcm] {
+          std::string message = getName() + " requesting handoff";
+          notifyHelperDroneObservers(message);
+
+          HelperDrone *helper_drone = nullptr;
+          helper_drone = selectClosestHelperDrone();
+          if (helper_drone != nullptr) {
+            std::string helper_name = helper_drone->getName();
+            std::string leader_name = this->getName();
+
+            std::string message2 =
+                helper_name + " accepted handoff for " + leader_name;
+            dcm->logEvent(helper_drone, "handoff_accepts", 1.0);
+
+            helper_drone->notify(message2);
+
+            // Handoff the package safely
+            helper_drone->getNextDelivery(this->getPackage());
+
+            Drone::setPackage(nullptr);
+          } else {
+            // package not handed off and leader not abandoning package
+            std::string message3 =
+                getName() +
+                "requesting handoff again, no helper drones available";
+            notifyHelperDroneObservers(message3);
+          }
+        });
       } else {
-        std::cout << getName() << "Battery EMERGENCY" << std::endl;
+        LOG_WARNING(getName() << " Battery EMERGENCY");
         std::string message4 =
             getName() +
             "going to charging station with package, no helpers available.";
-        model->notify(message4);
+        commit([this, message4] { model->notify(message4); });
       }
     } else if (toPackage && !pickedUp) {
       std::string message5 =
           getName() + " abandoning pickup due to critical battery level.";
-      model->notify(message5);
 
       // Return the package to scheduled deliveries
-      if (package) {
-        model->scheduledDeliveries.push_back(package);
-        model->sortScheduledDeliveries();
-        Drone::setPackage(nullptr);
-      }
+      commit([this, message5, package] {
+        model->notify(message5);
+        if (package) {
+          model->scheduledDeliveries.push_back(package);
+          model->sortScheduledDeliveries();
+          model->wakeAwaitingDelivery();
+        }
+      });
+      Drone::setPackage(nullptr);
 
       // Clear the toPackage path
-      delete toPackage;
-      toPackage = nullptr;
+      toPackage.reset();
     }
     pickedUp = false;
 
@@ -258,7 +340,7 @@ void LeaderDrone::update(double dt) {  // setup pointer to current package
 // handoffResponses
 void LeaderDrone::receiveHelperResponse(HelperDrone *drone, double distance) {
   if (drone != nullptr) {
-    handoffResponses[drone] = distance;
+    handoffResponses[drone->getId()] = {drone, distance};
   }
 }
 
@@ -270,7 +352,7 @@ HelperDrone *LeaderDrone::selectClosestHelperDrone() {
 
   // Check if there are any responses
   if (handoffResponses.empty()) {
-    std::cout << "DEBUG: No handoff responses received" << std::endl;
+    LOG_DEBUG("No handoff responses received");
     return nullptr;
   }
 
@@ -281,15 +363,12 @@ HelperDrone *LeaderDrone::selectClosestHelperDrone() {
   // choice of structure prompts used were: when to use map vs set vs other
   // structure, show me how to iterate with for loop through
   // std::map<HelperDrone *, double> handoffResponses;
-  for (const auto &pair : handoffResponses) {
-    HelperDrone *drone = pair.first;
-    double distance = pair.second;
-
-    // Make sure the drone pointer is valid
-    if (drone == nullptr) {
-      std::cerr << "WARNING: Null drone in handoffResponses" << std::endl;
-      continue;
-    }
+  for (const auto &[id, response] : handoffResponses) {
+    HelperDrone *drone = response.helper;
+    double distance = response.distance;
+
+    // the helper was removed after it answered
+    if (drone == nullptr) continue;
 
     // Get the smallest distance and set the closest drone
     if (smallest_distance < 0 || distance < smallest_distance) {
@@ -2,8 +2,15 @@
 
 #include "DataCollectionManager.h"
 #include "Robot.h"
+#include "SimulationContext.h"
+#include "SimulationModel.h"
+#include "Snapshot.h"
 
-Package::Package(const JsonObject &obj) : IEntity(obj) {}
+Package::Package(const JsonObject &obj) : IEntity(obj) {
+  lastPosition = getPosition();
+}
+
+Package::~Package() { delete priority; }
 
 Vector3 Package::getDestination() const { return destination; }
 
@@ -19,16 +26,22 @@ void Package::setStrategyName(std::string strategyName_) {
 
 void Package::update(double dt) {
   // DCM integration
-  DataCollectionManager *dcm = DataCollectionManager::getInstance();
+  DataCollectionManager *dcm = &getContext().getDataCollection();
   dcm->logEvent(this, "timesteps_of_entity", 1.0);
+
+  // a package only moves while a drone carries it, which wakes it again
+  if (getPosition() == lastPosition) sleep();
+  lastPosition = getPosition();
 }
 
 void Package::setPriority(PriorityShipping *newPriority) {
-  if (!pickedUp && !isDelivered) {
+  if (!getPackagePickedUp() && !getDeliveredPackage()) {
     if (priority) {
       delete priority;
     }
     priority = newPriority;
+    // the view shows the priority
+    wake();
   }
 }
 
@@ -44,12 +57,36 @@ int Package::getPriorityLevel() const {
   return 1;
 }
 
-void Package::isPickedUp() { pickedUp = true; }
+bool Package::isScheduled() const {
+  return delivery() >= EntityStore::DeliveryState::Scheduled;
+}
+
+void Package::setScheduled(bool val) {
+  if (!val) {
+    delivery() = EntityStore::DeliveryState::Unscheduled;
+  } else if (!isScheduled()) {
+    delivery() = EntityStore::DeliveryState::Scheduled;
+  }
+}
 
-bool Package::getPackagePickedUp() const { return pickedUp; }
-void Package::DeliveredPackage() { isDelivered = true; }
+void Package::isPickedUp() {
+  if (!getPackagePickedUp()) delivery() = EntityStore::DeliveryState::PickedUp;
+}
 
-bool Package::getDeliveredPackage() const { return isDelivered; }
+bool Package::getPackagePickedUp() const {
+  return delivery() >= EntityStore::DeliveryState::PickedUp;
+}
+void Package::DeliveredPackage() {
+  delivery() = EntityStore::DeliveryState::Delivered;
+}
+
+bool Package::getDeliveredPackage() const {
+  return delivery() == EntityStore::DeliveryState::Delivered;
+}
+
+EntityStore::DeliveryState &Package::delivery() const {
+  return store().delivery(getId());
+}
 
 void Package::initDelivery(Robot *owner) {
   this->owner = owner;
@@ -62,4 +99,34 @@ void Package::handOff() {
   if (owner) {
     owner->receive(this);
   }
+  if (model) model->packageDelivered(this);
+}
+
+void Package::save(SnapshotWriter &out) const {
+  IEntity::save(out);
+  out.write(requiresDelivery_);
+  out.write(destination);
+  out.write(lastPosition);
+  out.write(strategyName);
+  out.write(owner ? owner->getId() : -1);
+  out.write(priority ? priority->getPriorityName() : std::string());
+}
+
+void Package::load(SnapshotReader &in) {
+  IEntity::load(in);
+  requiresDelivery_ = in.read<bool>();
+  destination = in.read<Vector3>();
+  lastPosition = in.read<Vector3>();
+  strategyName = in.readString();
+  owner = dynamic_cast<Robot *>(model->getEntity(in.read<int>()));
+  std::string priorityName = in.readString();
+  delete priority;
+  priority = nullptr;
+  if (priorityName == "Standard") {
+    priority = new StandardShipping();
+  } else if (priorityName == "NoRush") {
+    priority = new NoRushShipping();
+  } else if (priorityName == "Expedited") {
+    priority = new ExpeditedShipping();
+  }
 }
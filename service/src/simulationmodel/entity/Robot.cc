@@ -1,13 +1,34 @@
 #include "Robot.h"
 
 #include "DataCollectionManager.h"
+#include "SimulationContext.h"
+#include "SimulationModel.h"
+#include "Snapshot.h"
 
 Robot::Robot(const JsonObject& obj) : IEntity(obj) {}
 
 void Robot::update(double dt) {
   // DCM integration
-  DataCollectionManager* dcm = DataCollectionManager::getInstance();
+  DataCollectionManager* dcm = &getContext().getDataCollection();
   dcm->logEvent(this, "timesteps_of_entity", 1.0);
+
+  // a robot only waits for its package
+  sleep();
+}
+
+void Robot::receive(Package* p) {
+  package = p;
+  wake();
 }
 
-void Robot::receive(Package* p) { package = p; }
+void Robot::save(SnapshotWriter& out) const {
+  IEntity::save(out);
+  out.write(requestedDelivery);
+  out.write(package ? package->getId() : -1);
+}
+
+void Robot::load(SnapshotReader& in) {
+  IEntity::load(in);
+  requestedDelivery = in.read<bool>();
+  package = dynamic_cast<Package*>(model->getEntity(in.read<int>()));
+}
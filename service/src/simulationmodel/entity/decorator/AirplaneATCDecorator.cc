@@ -5,21 +5,8 @@
 AirplaneATCDecorator::AirplaneATCDecorator(Airplane* airplane)
     : AirplaneDecorator(airplane) {}
 
-void AirplaneATCDecorator::reroute() {
-  Vector3 position = sub->getPosition();
-  Vector3 direction = sub->getDirection();
-
-  double angle = 15.0 * M_PI / 180.0;
-  Vector3 deflectDir(direction.x * cos(angle) - direction.z * sin(angle),
-                     direction.y,
-                     direction.x * sin(angle) + direction.z * cos(angle));
-  Vector3 newTarget = position + deflectDir * 400.0;
-
-  if (reroutedDestination) {
-    delete reroutedDestination;
-  }
-  reroutedDestination = new BeelineStrategy(position, newTarget);
-  rerouted = true;
+void AirplaneATCDecorator::reroute(const Vector3& velocity, double duration) {
+  detour(velocity, duration, 400.0);
 }
 
 void AirplaneATCDecorator::update(double dt) {
@@ -32,8 +19,7 @@ void AirplaneATCDecorator::update(double dt) {
         sub->notifyObservers(message);
         timeSinceReroute = 0;
       }
-      delete reroutedDestination;
-      reroutedDestination = nullptr;
+      reroutedDestination.reset();
       rerouted = false;
     }
   } else {
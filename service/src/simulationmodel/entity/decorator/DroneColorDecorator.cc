@@ -1,5 +1,7 @@
 #include "DroneColorDecorator.h"
 
+#include "Snapshot.h"
+
 DroneColorDecorator::DroneColorDecorator(Drone* d, double h, double s, double l)
     : DroneDecorator(d), hue(h), saturation(s), light(l) {}
 
@@ -108,3 +110,21 @@ void DroneColorDecorator::update(double dt) {
   }
 }
 Drone* DroneColorDecorator::getDecoratedEntity() const { return sub; }
+
+void DroneColorDecorator::save(SnapshotWriter& out) const {
+  DroneDecorator::save(out);
+  out.write(hue);
+  out.write(saturation);
+  out.write(light);
+  out.write(distToPackage);
+  out.write(distToDestination);
+}
+
+void DroneColorDecorator::load(SnapshotReader& in) {
+  DroneDecorator::load(in);
+  hue = in.read<double>();
+  saturation = in.read<double>();
+  light = in.read<double>();
+  distToPackage = in.read<double>();
+  distToDestination = in.read<double>();
+}
@@ -1,9 +1,11 @@
 #include "AirplaneFactory.h"
 
+#include "Log.h"
+
 IEntity* AirplaneFactory::createEntity(const JsonObject& entity) {
   std::string type = entity["type"];
   if (type.compare("airplane") == 0) {
-    std::cout << "Airplane Created" << std::endl;
+    LOG_DEBUG("Airplane Created");
     return new AirplaneATCDecorator(new Airplane(entity));
   }
   return nullptr;
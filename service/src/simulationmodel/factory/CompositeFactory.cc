@@ -1,5 +1,7 @@
 #include "CompositeFactory.h"
 
+#include "Log.h"
+
 IEntity* CompositeFactory::createEntity(const JsonObject& entity) {
   for (int i = 0; i < componentFactories.size(); i++) {
     IEntity* createdEntity = componentFactories.at(i)->createEntity(entity);
@@ -7,7 +9,7 @@ IEntity* CompositeFactory::createEntity(const JsonObject& entity) {
       return createdEntity;
     }
   }
-  std::cout << "[!] Error: Type mismatched..." << std::endl;
+  LOG_WARNING("[!] Error: Type mismatched...");
   return nullptr;
 }
 
@@ -1,9 +1,11 @@
 #include "HelicopterFactory.h"
 
+#include "Log.h"
+
 IEntity* HelicopterFactory::createEntity(const JsonObject& entity) {
   std::string type = entity["type"];
   if (type.compare("helicopter") == 0) {
-    std::cout << "Helicopter Created" << std::endl;
+    LOG_DEBUG("Helicopter Created");
     return new HelicopterATCDecorator(new Helicopter(entity));
   }
   return nullptr;
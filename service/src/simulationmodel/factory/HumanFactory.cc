@@ -1,9 +1,11 @@
 #include "HumanFactory.h"
 
+#include "Log.h"
+
 IEntity* HumanFactory::createEntity(const JsonObject& entity) {
   std::string type = entity["type"];
   if (type.compare("human") == 0) {
-    std::cout << "Human Created" << std::endl;
+    LOG_DEBUG("Human Created");
     return new Human(entity);
   }
   return nullptr;
@@ -1,10 +1,12 @@
 #include "PackageFactory.h"
 
+#include "Log.h"
+
 IEntity* PackageFactory::createEntity(const JsonObject& entity) {
   std::string type = entity["type"];
   if (type.compare("package") == 0) {
     Package* p = new Package(entity);
-    std::cout << "Package Created" << std::endl;
+    LOG_DEBUG("Package Created");
     return p;
   }
   return nullptr;
@@ -1,9 +1,11 @@
 #include "RobotFactory.h"
 
+#include "Log.h"
+
 IEntity* RobotFactory::createEntity(const JsonObject& entity) {
   std::string type = entity["type"];
   if (type.compare("robot") == 0) {
-    std::cout << "Robot Created" << std::endl;
+    LOG_DEBUG("Robot Created");
     return new Robot(entity);
   }
   return nullptr;
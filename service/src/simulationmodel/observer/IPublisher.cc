@@ -1,13 +1,13 @@
 #include "IPublisher.h"
 
-#include <iostream>
+#include "Log.h"
 
 void IPublisher::addObserver(const IObserver* o) { observers.insert(o); }
 
 void IPublisher::addHelperDroneObserver(const IObserver* o) {
   // Add the new observer
   helperDroneObservers.insert(o);
-  std::cout << helperDroneObservers.size() << std::endl;
+  LOG_DEBUG(helperDroneObservers.size() << " helper drone observers");
 }
 
 void IPublisher::removeObserver(const IObserver* o) { observers.erase(o); }
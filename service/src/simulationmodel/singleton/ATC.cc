@@ -5,115 +5,259 @@
 
 #include "ATC.h"
 
-#include <cmath>
-#include <iostream>
+#include <chrono>
+#include <stdexcept>
 
-#include "AirplaneDecorator.h"
 #include "DataCollectionManager.h"
-#include "DroneDecorator.h"
-#include "HelicopterDecorator.h"
+#include "Snapshot.h"
 
-ATC ATC::instance;
+ATC::ATC(DataCollectionManager& dataCollection, EntityStore& store)
+    : dataCollection(dataCollection), store(store), commands(4096) {}
 
-ATC::ATC() {}
+ATC::~ATC() { stopThread(); }
 
-ATC::~ATC() {}
+int ATC::addEntity(IEntity* entity) {
+  int handle = entity->getId();
+  auto it = slots.find(handle);
+  if (it != slots.end()) {
+    flyingEntities[it->second] = entity;
+    routeChanged(handle);
+    return handle;
+  }
+  slots[handle] = flyingEntities.size();
+  flyingEntities.push_back(entity);
+  handles.push_back(handle);
+  return handle;
+}
 
-ATC& ATC::getInstance() { return instance; }
+void ATC::removeEntity(int handle) {
+  auto it = slots.find(handle);
+  if (it == slots.end()) return;
 
-void ATC::addEntity(IEntity* entity) { flyingEntities.push_back(entity); }
+  size_t slot = it->second;
+  size_t last = flyingEntities.size() - 1;
+  if (slot != last) {
+    // move the last entity into the vacated slot
+    flyingEntities[slot] = flyingEntities[last];
+    handles[slot] = handles[last];
+    slots[handles[slot]] = slot;
+  }
+  flyingEntities.pop_back();
+  handles.pop_back();
+  slots.erase(it);
+  airspace.remove(handle);
+  // the removal shows up in the next snapshot, and commands still addressed
+  // to the handle are dropped
+}
 
-void ATC::update(double dt) {
-  // DCM integration
-  DataCollectionManager* dcm = DataCollectionManager::getInstance();
+bool ATC::isRegistered(int handle) const { return slots.count(handle) > 0; }
+
+size_t ATC::size() const { return flyingEntities.size(); }
+
+void ATC::routeChanged(int handle) {
+  if (slots.count(handle)) back.routeChanges.push_back(handle);
+}
 
-  for (size_t i = 0; i < flyingEntities.size(); ++i) {
-    for (size_t j = i + 1; j < flyingEntities.size(); ++j) {
-      if (willCollide(flyingEntities[i], flyingEntities[j])) {
-        dcm->logEvent(flyingEntities[i], "potential_collisions", 1.0);
-        dcm->logEvent(flyingEntities[j], "potential_collisions", 1.0);
+std::vector<int> ATC::conflictCandidates(const Vector3& position,
+                                        const Vector3& velocity, double time,
+                                        double radius) {
+  if (airspaceStale) {
+    for (size_t slot = 0; slot < flyingEntities.size(); ++slot) {
+      IEntity* entity = flyingEntities[slot];
+      FlightState state{handles[slot], entity->getPosition(),
+                        entity->getDirection(), entity->getSpeed(),
+                        entity->isRerouted()};
+      airspace.update(state.handle, ConflictDetector::airspace(state),
+                      ConflictDetector::airspaceMargin(state));
+    }
+    airspaceStale = false;
+  }
 
-        if (!(flyingEntities[i]->isRerouted())) {
-          flyingEntities[i]->reroute();
+  SweptCapsuleTree::Capsule path;
+  path.start = position;
+  path.end = position + velocity * time;
+  path.radius = radius;
+  std::vector<int> candidates;
+  airspace.query(path, candidates);
+  return candidates;
+}
 
-          dcm->logEvent(flyingEntities[j], "reroute_count", 1.0);
-        } else if (!(flyingEntities[j]->isRerouted())) {
-          flyingEntities[j]->reroute();
+void ATC::applyCommands() {
+  // DCM integration
+  DataCollectionManager* dcm = &dataCollection;
 
-          dcm->logEvent(flyingEntities[j], "reroute_count", 1.0);
-        } else {
-          dcm->logEvent(flyingEntities[i], "collision_unavoidable", 1.0);
-        }
-      }
+  ATCCommand command;
+  while (commands.pop(command)) {
+    appliedCommands = command.sequence;
+    if (command.type == ATCCommand::Type::LogSystem) {
+      dcm->logSystemEvent("ATC", command.name, command.value);
+      continue;
+    }
+
+    auto it = slots.find(command.handle);
+    if (it == slots.end()) continue;
+    IEntity* entity = flyingEntities[it->second];
+    switch (command.type) {
+      case ATCCommand::Type::Reroute:
+        entity->reroute(command.velocity, command.value);
+        break;
+      case ATCCommand::Type::Log:
+        dcm->logEvent(entity, command.name, command.value);
+        break;
+      case ATCCommand::Type::LogMinimum:
+        dcm->logMinimum(entity, command.name, command.value);
+        break;
+      default:
+        break;
     }
   }
 }
 
-bool ATC::willCollide(IEntity* a, IEntity* b) {
-  const float altitudeThreshold = 50.0f;
-  const float baseCollisionTime = 5.0f;
-  const float collisionDistanceThreshold = 50.0f;
-
-  Vector3 posA = a->getPosition();
-  Vector3 posB = b->getPosition();
-  Vector3 dirA = a->getDirection().normalize();
-  Vector3 dirB = b->getDirection().normalize();
-  float speedA = a->getSpeed();
-  float speedB = b->getSpeed();
-
-  float altitudeDiff = std::abs(posA.y - posB.y);
-  if (altitudeDiff > altitudeThreshold) {
-    return false;
+void ATC::update(double dt) {
+  simTime += dt;
+  airspaceStale = true;
+  back.time = simTime;
+  back.appliedCommands = appliedCommands;
+  back.entities.clear();
+  // handles are entity ids, so the kinematic state comes straight from the
+  // entity store
+  for (size_t slot = 0; slot < flyingEntities.size(); ++slot) {
+    size_t row = store.row(handles[slot]);
+    back.entities.push_back({handles[slot], store.positions[row],
+                             store.directions[row], store.speeds[row],
+                             flyingEntities[slot]->isRerouted()});
   }
 
-  float maxSpeed = std::max(speedA, speedB);
-  float collisionTimeThreshold = baseCollisionTime * pow(maxSpeed, 2) * 0.05;
-  float maxDistance = 0.5 * collisionTimeThreshold;
-  float currentDistance = (posA - posB).magnitude();
-  if (currentDistance > maxDistance) {
-    return false;
+  if (!threaded) {
+    evaluate(back, true);
+    back.routeChanges.clear();
+    return;
   }
 
-  Vector3 relPos = posB - posA;
-  Vector3 relVel = dirB * speedB - dirA * speedA;
+  if (!worker.joinable()) {
+    stopping = false;
+    worker = std::thread(&ATC::run, this);
+  }
+  {
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    // route changes of a snapshot the ATC never picked up still count
+    if (snapshotFresh) {
+      back.routeChanges.insert(back.routeChanges.begin(),
+                               published.routeChanges.begin(),
+                               published.routeChanges.end());
+    }
+    std::swap(back, published);
+    snapshotFresh = true;
+  }
+  snapshotReady.notify_one();
+  back.routeChanges.clear();
+}
 
-  float relSpeedSquared = relVel * relVel;
-  if (relSpeedSquared < 1) {
-    return currentDistance < collisionDistanceThreshold;
+void ATC::setThreaded(bool threaded) {
+  if (this->threaded == threaded) return;
+  if (!threaded) {
+    stopThread();
+    // carry over what the thread never picked up so no route change is lost
+    if (snapshotFresh) {
+      snapshotFresh = false;
+      back.routeChanges.insert(back.routeChanges.begin(),
+                               published.routeChanges.begin(),
+                               published.routeChanges.end());
+    }
   }
+  this->threaded = threaded;
+}
 
-  float tClosest = -(relPos * relVel) / relSpeedSquared;
+bool ATC::isThreaded() const { return threaded; }
 
-  if (tClosest < 0 || tClosest > collisionTimeThreshold) {
-    return false;
+void ATC::quiesce() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(snapshotMutex);
+      auto idle = [this] {
+        return !worker.joinable() || (!snapshotFresh && !evaluating);
+      };
+      if (workerIdle.wait_for(lock, std::chrono::milliseconds(1), idle)) {
+        break;
+      }
+    }
+    // the thread waits for room in a full queue, which only we can make
+    applyCommands();
   }
+  applyCommands();
+}
 
-  Vector3 futurePosA = posA + dirA * speedA * tClosest;
-  Vector3 futurePosB = posB + dirB * speedB * tClosest;
-  float distanceAtClosest = (futurePosA - futurePosB).magnitude();
+void ATC::save(SnapshotWriter& out) const {
+  out.write(simTime);
+  out.write(appliedCommands);
+  // conflicts are resolved in registration order
+  out.write(static_cast<std::uint64_t>(handles.size()));
+  for (int handle : handles) out.write(handle);
+  detector.save(out);
+}
 
-  return distanceAtClosest < collisionDistanceThreshold;
+void ATC::load(SnapshotReader& in) {
+  simTime = in.read<double>();
+  appliedCommands = in.read<unsigned long>();
+  std::uint64_t count = in.read<std::uint64_t>();
+  for (std::uint64_t slot = 0; slot < count; ++slot) {
+    int handle = in.read<int>();
+    auto it = slots.find(handle);
+    if (it == slots.end() || slot >= handles.size()) {
+      throw std::runtime_error("Snapshot has an unknown ATC handle");
+    }
+    // swap the registration into its saved slot
+    size_t from = it->second;
+    std::swap(flyingEntities[slot], flyingEntities[from]);
+    std::swap(handles[slot], handles[from]);
+    slots[handles[slot]] = slot;
+    slots[handles[from]] = from;
+  }
+  detector.load(in);
+  airspaceStale = true;
 }
 
-IEntity* ATC::chooseEntity(int i, int j) {
-  int choice = rand() % 2;
+void ATC::run() {
+  std::unique_lock<std::mutex> lock(snapshotMutex);
+  while (true) {
+    snapshotReady.wait(lock, [this] { return snapshotFresh || stopping; });
+    if (stopping) return;
 
-  if (choice == 0) {
-    if (!flyingEntities[i]->isRerouted()) {
-      return flyingEntities[i];
-    } else if (!flyingEntities[j]->isRerouted()) {
-      return flyingEntities[j];
-    } else {
-      return nullptr;
-    }
+    std::swap(working, published);
+    snapshotFresh = false;
+    evaluating = true;
+    lock.unlock();
+    evaluate(working, false);
+    lock.lock();
+    evaluating = false;
+    workerIdle.notify_all();
+  }
+}
 
-  } else {
-    if (!flyingEntities[j]->isRerouted()) {
-      return flyingEntities[j];
-    } else if (!flyingEntities[i]->isRerouted()) {
-      return flyingEntities[i];
-    } else {
-      return nullptr;
+void ATC::stopThread() {
+  if (!worker.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    stopping = true;
+  }
+  snapshotReady.notify_one();
+  worker.join();
+}
+
+void ATC::evaluate(const FlightSnapshot& snapshot, bool onSimulationThread) {
+  output.clear();
+  detector.process(snapshot, output);
+  for (const ATCCommand& command : output) {
+    while (!commands.push(command)) {
+      // the simulation drains the queue every tick; on the simulation thread
+      // nobody else will, so drain it here
+      if (onSimulationThread) {
+        applyCommands();
+      } else if (stopping) {
+        return;
+      } else {
+        std::this_thread::yield();
+      }
     }
   }
 }
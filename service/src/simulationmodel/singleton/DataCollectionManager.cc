@@ -12,15 +12,30 @@
 #include <fstream>
 #include <iostream>
 
-DataCollectionManager* DataCollectionManager::instance = nullptr;
+#include "Log.h"
+#include "Snapshot.h"
 
-DataCollectionManager* DataCollectionManager::getInstance() {
-  if (instance == nullptr) {
-    instance = new DataCollectionManager();
+namespace {
+void saveMetrics(SnapshotWriter& out,
+                 const std::map<std::string, double>& metrics) {
+  out.write(static_cast<std::uint64_t>(metrics.size()));
+  for (const auto& [name, value] : metrics) {
+    out.write(name);
+    out.write(value);
   }
-  return instance;
 }
 
+std::map<std::string, double> loadMetrics(SnapshotReader& in) {
+  std::map<std::string, double> metrics;
+  std::uint64_t count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    std::string name = in.readString();
+    metrics[name] = in.read<double>();
+  }
+  return metrics;
+}
+}  // namespace
+
 void DataCollectionManager::createLog(IEntity* entity) {
   if (entity != nullptr) {
     if (logMap.count(entity->getId()) == 0) {
@@ -56,12 +71,20 @@ void DataCollectionManager::exportLog() {
     for (const auto& event : entity.second) {
       fileout << name << ", " << pointer << ", " << event.first << ", "
               << event.second << std::endl;
-      std::cout << "Log metric exported for " << name << ": " << event.first
-                << std::endl;
+      LOG_DEBUG("Log metric exported for " << name << ": " << event.first);
+    }
+  }
+
+  for (const auto& component : systemLog) {
+    for (const auto& event : component.second) {
+      fileout << component.first << ", -1, " << event.first << ", "
+              << event.second << std::endl;
+      LOG_DEBUG("Log metric exported for " << component.first << ": "
+                                           << event.first);
     }
   }
 
-  std::cout << "All logs exported to " << filename << std::endl;
+  LOG_INFO("All logs exported to " << filename);
   fileout.close();
 
   std::string message = "Logs have been successfully exported to " + filename;
@@ -70,10 +93,12 @@ void DataCollectionManager::exportLog() {
 
 void DataCollectionManager::logEvent(IEntity* entity, std::string eventName,
                                      double metric) {
-  // increment eventName by metric
+  // increment eventName by metric; entities log their own metrics during the
+  // parallel update, so only the entity's own log may change here
 
-  if (logMap.count(entity->getId())) {
-    auto& logOfEntity = logMap[entity->getId()];
+  auto log = logMap.find(entity->getId());
+  if (log != logMap.end()) {
+    auto& logOfEntity = log->second;
     if (logOfEntity.count(eventName)) {
       logOfEntity[eventName] += metric;  // increment
     } else {
@@ -86,6 +111,19 @@ void DataCollectionManager::logEvent(IEntity* entity, std::string eventName,
   }
 }
 
+void DataCollectionManager::logMinimum(IEntity* entity, std::string eventName,
+                                       double metric) {
+  if (logMap.count(entity->getId())) {
+    auto& logOfEntity = logMap[entity->getId()];
+    auto event = logOfEntity.find(eventName);
+    if (event == logOfEntity.end()) {
+      logOfEntity[eventName] = metric;
+    } else if (metric < event->second) {
+      event->second = metric;
+    }
+  }
+}
+
 void DataCollectionManager::removeEntity(IEntity* entity) {
   if (logMap.count(entity->getId()) > 0) {
     logMap.erase(entity->getId());
@@ -93,3 +131,48 @@ void DataCollectionManager::removeEntity(IEntity* entity) {
     // std::endl;
   }
 }
+
+void DataCollectionManager::logSystemEvent(const std::string& component,
+                                           const std::string& eventName,
+                                           double metric) {
+  systemLog[component][eventName] += metric;
+}
+
+void DataCollectionManager::save(SnapshotWriter& out) const {
+  out.write(static_cast<std::uint64_t>(logMap.size()));
+  for (const auto& [id, metrics] : logMap) {
+    out.write(id);
+    saveMetrics(out, metrics);
+  }
+  out.write(static_cast<std::uint64_t>(idToName.size()));
+  for (const auto& [id, name] : idToName) {
+    out.write(id);
+    out.write(name);
+  }
+  out.write(static_cast<std::uint64_t>(systemLog.size()));
+  for (const auto& [component, metrics] : systemLog) {
+    out.write(component);
+    saveMetrics(out, metrics);
+  }
+}
+
+void DataCollectionManager::load(SnapshotReader& in) {
+  logMap.clear();
+  idToName.clear();
+  systemLog.clear();
+  std::uint64_t count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    int id = in.read<int>();
+    logMap[id] = loadMetrics(in);
+  }
+  count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    int id = in.read<int>();
+    idToName[id] = in.readString();
+  }
+  count = in.read<std::uint64_t>();
+  for (std::uint64_t i = 0; i < count; ++i) {
+    std::string component = in.readString();
+    systemLog[component] = loadMetrics(in);
+  }
+}
@@ -0,0 +1,57 @@
+#include "StrategyPool.h"
+
+#include "IStrategy.h"
+
+StrategyHandle::StrategyHandle(StrategyHandle&& other)
+    : strategy(other.strategy), pool(other.pool) {
+  other.strategy = nullptr;
+  other.pool = nullptr;
+}
+
+StrategyHandle& StrategyHandle::operator=(StrategyHandle&& other) {
+  if (this != &other) {
+    reset();
+    std::swap(strategy, other.strategy);
+    std::swap(pool, other.pool);
+  }
+  return *this;
+}
+
+StrategyHandle::~StrategyHandle() { reset(); }
+
+void StrategyHandle::reset() {
+  if (strategy) pool->release(strategy);
+  strategy = nullptr;
+  pool = nullptr;
+}
+
+StrategyPool::StrategyPool() : blocks(blockSize) {}
+
+std::vector<double> StrategyPool::takeLengths() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (spareLengths.empty()) return {};
+  std::vector<double> lengths = std::move(spareLengths.back());
+  spareLengths.pop_back();
+  return lengths;
+}
+
+void StrategyPool::giveLengths(std::vector<double>&& lengths) {
+  if (lengths.capacity() == 0) return;
+  lengths.clear();
+  std::lock_guard<std::mutex> lock(mutex);
+  if (spareLengths.size() < maxSpareLengths) {
+    spareLengths.push_back(std::move(lengths));
+  }
+}
+
+size_t StrategyPool::getCapacity() const { return blocks.getCapacity(); }
+
+size_t StrategyPool::getInUse() const { return blocks.getInUse(); }
+
+void StrategyPool::release(IStrategy* strategy) {
+  // the block starts at the most derived object
+  void* block = dynamic_cast<void*>(strategy);
+  // the destructor gives buffers back, so it runs outside the lock
+  strategy->~IStrategy();
+  blocks.deallocate(block);
+}
@@ -1,4 +1,11 @@
 #include "BeelineStrategy.h"
 
+#include "SimulationContext.h"
+
 BeelineStrategy::BeelineStrategy(Vector3 pos, Vector3 des)
     : PathStrategy({pos, des}) {}
+
+StrategyHandle BeelineStrategy::create(IEntity* entity, Vector3 pos,
+                                       Vector3 des) {
+  return entity->getContext().getStrategies().make<BeelineStrategy>(pos, des);
+}
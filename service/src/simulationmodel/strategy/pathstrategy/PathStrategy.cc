@@ -1,17 +1,188 @@
 #include "PathStrategy.h"
 
-PathStrategy::PathStrategy(std::vector<Vector3> p) : path(p), index(0) {}
+#include <atomic>
+
+#include "SimulationContext.h"
+#include "Snapshot.h"
+
+namespace {
+// strategies are created on the worker threads too
+std::atomic<unsigned long> nextToken = 1;
+}  // namespace
+
+PathStrategy::PathStrategy(std::vector<Vector3> p)
+    : path(p), index(0), token(nextToken++) {}
+
+PathStrategy::~PathStrategy() {
+  disarm();
+  if (lengthPool) lengthPool->giveLengths(std::move(arcLength));
+}
 
 void PathStrategy::move(IEntity* entity, double dt) {
   if (isCompleted()) return;
+  if (arcLength.size() != path.size()) {
+    measure(entity->getContext().getStrategies());
+  }
 
-  Vector3 vi = path[index];
-  Vector3 dir = (vi - entity->getPosition()).unit();
+  double step = entity->getSpeed() * dt;
+  Vector3 position = entity->getPosition();
+  int count = static_cast<int>(path.size());
 
-  entity->setPosition(entity->getPosition() + dir * entity->getSpeed() * dt);
-  entity->setDirection(dir);
+  // still on the stretch the store stepped: take its result
+  EntityStore& store = entity->getContext().getStore();
+  if (onPath && walker == entity->getId() && walkStore == &store &&
+      store.contains(walker)) {
+    size_t row = store.row(walker);
+    if (store.walkers[row] == token && store.walkedDt == dt &&
+        step < store.walkLengths[row] && position == resume) {
+      travelled += step;
+      store.walkLengths[row] -= step;
+      resume = store.walkSteps[row];
+      entity->setPosition(resume);
+      if (arcLength.back() - travelled < arrivalRadius) {
+        index = count;
+        disarm();
+      }
+      return;
+    }
+  }
 
-  if (entity->getPosition().dist(vi) < 4) index++;
+  // at the start, or after something else moved the entity (a detour),
+  // head straight for the next waypoint before following the path again
+  if (!onPath || !(position == resume)) {
+    // a detour that passed close by a waypoint, or carried the entity
+    // beyond it along the next segment, counts as having reached it, so the
+    // entity does not turn back for it
+    while (!(position == resume) && index + 1 < count &&
+           (position.dist(path[index]) < arrivalRadius ||
+            (position - path[index]) * (path[index + 1] - path[index]) > 0)) {
+      index++;
+    }
+    Vector3 toWaypoint = path[index] - position;
+    double gap = toWaypoint.magnitude();
+    if (gap > step) {
+      Vector3 dir = toWaypoint.unit();
+      resume = position + dir * step;
+      onPath = false;
+      entity->setPosition(resume);
+      entity->setDirection(dir);
+      disarm();
+      if (index + 1 == count && gap - step < arrivalRadius) index++;
+      return;
+    }
+    step -= gap;
+    travelled = arcLength[index];
+    onPath = true;
+  }
+
+  travelled += step;
+  while (index < count && arcLength[index] <= travelled) index++;
+
+  if (isCompleted()) {
+    resume = path.back();
+    entity->setPosition(resume);
+    disarm();
+    return;
+  }
+
+  // the segment ending at path[index] has a length, or index would have
+  // passed it
+  Vector3 dir = (path[index] - path[index - 1]).unit();
+  resume = path[index - 1] + dir * (travelled - arcLength[index - 1]);
+  entity->setPosition(resume);
+  entity->setDirection(dir);
+  if (arcLength.back() - travelled < arrivalRadius) {
+    index = count;
+    disarm();
+  } else {
+    arm(store, entity->getId());
+  }
 }
 
 bool PathStrategy::isCompleted() { return index >= path.size(); }
+
+void PathStrategy::measure(StrategyPool& pool) {
+  if (!lengthPool) {
+    lengthPool = &pool;
+    arcLength = pool.takeLengths();
+  }
+  arcLength.resize(path.size());
+  double length = 0;
+  for (size_t i = 0; i < path.size(); ++i) {
+    if (i > 0) length += path[i].dist(path[i - 1]);
+    arcLength[i] = length;
+  }
+}
+
+void PathStrategy::arm(EntityStore& store, int id) {
+  if (!store.contains(id)) return;
+  // the entity walks one stretch at a time
+  if (walker != id || walkStore != &store) disarm();
+  size_t row = store.row(id);
+  store.walkers[row] = token;
+  store.walkDirections[row] = (path[index] - path[index - 1]).unit();
+  store.walkLengths[row] = arcLength[index] - travelled;
+  walker = id;
+  walkStore = &store;
+}
+
+void PathStrategy::disarm() {
+  if (walkStore && walkStore->contains(walker)) {
+    size_t row = walkStore->row(walker);
+    if (walkStore->walkers[row] == token) {
+      walkStore->walkers[row] = 0;
+      walkStore->walkDirections[row] = Vector3();
+      walkStore->walkLengths[row] = 0;
+    }
+  }
+  walker = -1;
+  walkStore = nullptr;
+}
+
+void PathStrategy::save(SnapshotWriter& out) const {
+  out.write(static_cast<std::uint64_t>(path.size()));
+  for (const Vector3& waypoint : path) out.write(waypoint);
+  out.write(index);
+  out.write(travelled);
+  out.write(resume);
+  out.write(onPath);
+  // the stretch in the store, if the entity is still walking it
+  bool armed = walkStore && walkStore->contains(walker) &&
+               walkStore->walkers[walkStore->row(walker)] == token;
+  out.write(armed);
+  if (armed) {
+    size_t row = walkStore->row(walker);
+    out.write(walkStore->walkDirections[row]);
+    out.write(walkStore->walkLengths[row]);
+  }
+}
+
+void PathStrategy::save(SnapshotWriter& out, const StrategyHandle& strategy) {
+  out.write(static_cast<bool>(strategy));
+  if (strategy) strategy->save(out);
+}
+
+StrategyHandle PathStrategy::load(SnapshotReader& in, IEntity* entity) {
+  if (!in.read<bool>()) return nullptr;
+  std::vector<Vector3> path(in.read<std::uint64_t>());
+  for (Vector3& waypoint : path) waypoint = in.read<Vector3>();
+  StrategyHandle handle =
+      entity->getContext().getStrategies().make<PathStrategy>(path);
+  PathStrategy* strategy = static_cast<PathStrategy*>(handle.get());
+  strategy->index = in.read<int>();
+  strategy->travelled = in.read<double>();
+  strategy->resume = in.read<Vector3>();
+  strategy->onPath = in.read<bool>();
+  if (in.read<bool>()) {
+    Vector3 direction = in.read<Vector3>();
+    double length = in.read<double>();
+    EntityStore& store = entity->getContext().getStore();
+    size_t row = store.row(entity->getId());
+    store.walkers[row] = strategy->token;
+    store.walkDirections[row] = direction;
+    store.walkLengths[row] = length;
+    strategy->walker = entity->getId();
+    strategy->walkStore = &store;
+  }
+  return handle;
+}
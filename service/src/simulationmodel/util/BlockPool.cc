@@ -0,0 +1,44 @@
+#include "BlockPool.h"
+
+namespace {
+// blocks are whole multiples of the strictest fundamental alignment
+constexpr size_t unit = sizeof(std::max_align_t);
+}  // namespace
+
+BlockPool::BlockPool(size_t size, size_t blocksPerChunk)
+    : blockSize((size + unit - 1) / unit * unit),
+      blocksPerChunk(blocksPerChunk) {}
+
+void* BlockPool::allocate() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (freeBlocks.empty()) {
+    size_t units = blockSize / unit;
+    chunks.push_back(std::make_unique_for_overwrite<std::max_align_t[]>(
+        units * blocksPerChunk));
+    std::max_align_t* chunk = chunks.back().get();
+    // hand out the chunk front to back
+    for (size_t i = blocksPerChunk; i-- > 0;) {
+      freeBlocks.push_back(chunk + i * units);
+    }
+  }
+  void* block = freeBlocks.back();
+  freeBlocks.pop_back();
+  return block;
+}
+
+void BlockPool::deallocate(void* block) {
+  std::lock_guard<std::mutex> lock(mutex);
+  freeBlocks.push_back(block);
+}
+
+size_t BlockPool::getBlockSize() const { return blockSize; }
+
+size_t BlockPool::getCapacity() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return chunks.size() * blocksPerChunk;
+}
+
+size_t BlockPool::getInUse() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return chunks.size() * blocksPerChunk - freeBlocks.size();
+}
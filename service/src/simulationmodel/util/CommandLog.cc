@@ -0,0 +1,92 @@
+#include "CommandLog.h"
+
+#include <set>
+
+CommandRecorder::CommandRecorder(const std::string& path,
+                                 const CommandLogHeader& header)
+    : file(path) {
+  JsonObject line;
+  line["seed"] = static_cast<double>(header.seed);
+  line["step"] = header.step;
+  line["syncATC"] = header.syncATC;
+  line["retireDelivered"] = header.retireDelivered;
+  file << line.toString() << std::endl;
+}
+
+CommandRecorder::~CommandRecorder() { flushUpdate(); }
+
+bool CommandRecorder::isOpen() const { return file.is_open() && file.good(); }
+
+void CommandRecorder::record(long tick, const std::string& command,
+                             const JsonObject& params) {
+  advance(tick);
+  flushUpdate();
+  write({tick, command, params});
+}
+
+void CommandRecorder::advance(long tick) {
+  if (tick > reached) reached = tick;
+}
+
+bool CommandRecorder::changesSimulation(const std::string& command) {
+  static const std::set<std::string> commands = {
+      "SetGraph",       "CreateEntity", "CreateEntities", "ScheduleTrip",
+      "ChangePriority", "writeStats",   "stopSimulation"};
+  return commands.count(command);
+}
+
+void CommandRecorder::write(const CommandLogEntry& entry) {
+  JsonObject line;
+  line["tick"] = static_cast<double>(entry.tick);
+  line["command"] = entry.command;
+  line["params"] = entry.params;
+  file << line.toString() << std::endl;
+  written = entry.tick;
+}
+
+void CommandRecorder::flushUpdate() {
+  // only the tick matters for an update, so one line covers all of them
+  if (reached > written) write({reached, "Update", JsonObject()});
+}
+
+CommandReader::CommandReader(const std::string& path) : file(path) {
+  std::string text;
+  if (!std::getline(file, text)) return;
+  picojson::value value;
+  if (!picojson::parse(value, text).empty() || !value.is<picojson::object>()) {
+    return;
+  }
+  JsonObject line(value.get<picojson::object>());
+  if (!line.contains("seed") || !line.contains("step")) return;
+  header.seed = static_cast<unsigned>(static_cast<double>(line["seed"]));
+  header.step = line["step"];
+  if (line.contains("syncATC")) header.syncATC = line["syncATC"];
+  if (line.contains("retireDelivered")) {
+    header.retireDelivered = line["retireDelivered"];
+  }
+  valid = header.step > 0;
+}
+
+bool CommandReader::isOpen() const { return valid; }
+
+const CommandLogHeader& CommandReader::getHeader() const { return header; }
+
+bool CommandReader::next(CommandLogEntry& entry) {
+  std::string text;
+  while (valid && std::getline(file, text)) {
+    if (text.empty()) continue;
+    picojson::value value;
+    if (!picojson::parse(value, text).empty() ||
+        !value.is<picojson::object>()) {
+      return false;
+    }
+    JsonObject line(value.get<picojson::object>());
+    if (!line.contains("tick") || !line.contains("command")) return false;
+    entry.tick = static_cast<long>(static_cast<double>(line["tick"]));
+    entry.command = std::string(line["command"]);
+    entry.params = line.contains("params") ? JsonObject(line["params"])
+                                           : JsonObject();
+    return true;
+  }
+  return false;
+}
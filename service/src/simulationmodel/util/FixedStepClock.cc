@@ -0,0 +1,45 @@
+#include "FixedStepClock.h"
+
+#include <algorithm>
+#include <cmath>
+
+FixedStepClock::FixedStepClock(double step, int maxSteps)
+    : step(step), maxSteps(std::max(1, maxSteps)) {}
+
+int FixedStepClock::advance(double elapsed, double speed) {
+  if (elapsed > 0 && speed > 0) accumulator += elapsed * speed;
+
+  // the small epsilon keeps a frame of exactly n steps from coming out as
+  // n - 1 steps plus a rounding error
+  double due = std::floor(accumulator / step + 1e-9);
+  // a fast-forward needs more steps for the same frame time, so only slow
+  // frames, not the speed, hit the cap
+  double cap = std::ceil(maxSteps * std::max(1.0, speed));
+  int count = static_cast<int>(std::min(due, cap));
+  accumulator = std::max(0.0, accumulator - count * step);
+  if (accumulator >= step) {
+    // overloaded: keep the partial step and drop the backlog
+    double kept = std::fmod(accumulator, step);
+    droppedTime += accumulator - kept;
+    accumulator = kept;
+  }
+
+  steps += count;
+  return count;
+}
+
+double FixedStepClock::getStep() const { return step; }
+
+int FixedStepClock::getMaxSteps() const { return maxSteps; }
+
+void FixedStepClock::setMaxSteps(int maxSteps) {
+  this->maxSteps = std::max(1, maxSteps);
+}
+
+double FixedStepClock::getTime() const { return steps * step; }
+
+double FixedStepClock::getAlpha() const {
+  return std::clamp(accumulator / step, 0.0, 1.0 - 1e-12);
+}
+
+double FixedStepClock::getDroppedTime() const { return droppedTime; }
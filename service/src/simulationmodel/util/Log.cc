@@ -0,0 +1,167 @@
+#include "Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "RingBuffer.h"
+
+namespace {
+// longer messages are cut off, so a record fits in four cache lines
+constexpr size_t textSize = 248;
+constexpr size_t capacity = 4096;
+
+/**
+ * @brief A message as it waits in the ring buffer
+ */
+struct Record {
+  LogLevel level = LogLevel::Info;
+  std::uint16_t size = 0;
+  char text[textSize];
+};
+
+/**
+ * @brief Owns the ring buffer and the thread that empties it
+ */
+class Writer {
+ public:
+  Writer() : records(capacity), thread([this] { run(); }) {}
+
+  ~Writer() {
+    stopping.store(true);
+    wakeups.fetch_add(1);
+    wakeups.notify_one();
+    thread.join();
+  }
+
+  void push(LogLevel level, const std::string& message) {
+    Record record;
+    record.level = level;
+    size_t size = std::min(message.size(), textSize);
+    record.size = static_cast<std::uint16_t>(size);
+    std::memcpy(record.text, message.data(), size);
+    if (message.size() > textSize) {
+      std::memcpy(record.text + textSize - 3, "...", 3);
+    }
+    if (!records.tryPush(record)) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    pushed.fetch_add(1);
+    // only a sleeping writer needs the system call
+    if (sleeping.load()) {
+      wakeups.fetch_add(1);
+      wakeups.notify_one();
+    }
+  }
+
+  void flush() {
+    unsigned long target = pushed.load();
+    unsigned long done = written.load();
+    while (done < target) {
+      written.wait(done);
+      done = written.load();
+    }
+  }
+
+  unsigned long getDropped() const {
+    return dropped.load(std::memory_order_relaxed);
+  }
+
+ private:
+  void run() {
+    Record record;
+    unsigned long reported = 0;
+    while (true) {
+      unsigned long count = 0;
+      while (records.tryPop(record)) {
+        std::ostream& out =
+            record.level >= LogLevel::Warning ? std::cerr : std::cout;
+        out.write(record.text, record.size).put('\n');
+        count++;
+      }
+      unsigned long lost = dropped.load(std::memory_order_relaxed);
+      if (lost != reported) {
+        std::cerr << (lost - reported) << " log messages dropped\n";
+        reported = lost;
+      }
+      if (count > 0) {
+        std::cout.flush();
+        written.fetch_add(count);
+        written.notify_all();
+        continue;
+      }
+      if (written.load() < pushed.load()) {
+        // a message is counted, but its push has not finished
+        std::this_thread::yield();
+        continue;
+      }
+      if (stopping.load()) break;
+
+      unsigned seen = wakeups.load();
+      sleeping.store(true);
+      // a push that missed the flag is counted by now
+      if (written.load() == pushed.load() && !stopping.load()) {
+        wakeups.wait(seen);
+      }
+      sleeping.store(false);
+    }
+  }
+
+  RingBuffer<Record> records;
+  std::atomic<unsigned long> pushed{0};
+  std::atomic<unsigned long> written{0};
+  std::atomic<unsigned long> dropped{0};
+  std::atomic<unsigned> wakeups{0};
+  std::atomic<bool> sleeping{false};
+  std::atomic<bool> stopping{false};
+  std::thread thread;
+};
+
+Writer& writer() {
+  static Writer instance;
+  return instance;
+}
+
+std::atomic<LogLevel> threshold{LogLevel::Info};
+}  // namespace
+
+void Log::setLevel(LogLevel level) {
+  threshold.store(level, std::memory_order_relaxed);
+}
+
+LogLevel Log::getLevel() {
+  return threshold.load(std::memory_order_relaxed);
+}
+
+bool Log::enabled(LogLevel level) {
+  return level != LogLevel::Off && level >= getLevel();
+}
+
+void Log::write(LogLevel level, const std::string& message) {
+  writer().push(level, message);
+}
+
+void Log::flush() { writer().flush(); }
+
+unsigned long Log::getDropped() { return writer().getDropped(); }
+
+bool Log::parseLevel(const std::string& name, LogLevel& level) {
+  if (name == "debug") {
+    level = LogLevel::Debug;
+  } else if (name == "info") {
+    level = LogLevel::Info;
+  } else if (name == "warning") {
+    level = LogLevel::Warning;
+  } else if (name == "error") {
+    level = LogLevel::Error;
+  } else if (name == "off") {
+    level = LogLevel::Off;
+  } else {
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,43 @@
+#include "Snapshot.h"
+
+#include <stdexcept>
+
+namespace {
+// "DSIM" in a file viewer
+constexpr std::uint32_t magic = 0x4d495344;
+}  // namespace
+
+SnapshotWriter::SnapshotWriter(std::ostream& out) : out(out) {
+  write(magic);
+  write(version);
+}
+
+void SnapshotWriter::write(const std::string& value) {
+  write(static_cast<std::uint64_t>(value.size()));
+  out.write(value.data(), value.size());
+}
+
+bool SnapshotWriter::good() const { return out.good(); }
+
+SnapshotReader::SnapshotReader(std::istream& in) : in(in) {
+  if (read<std::uint32_t>() != magic) {
+    throw std::runtime_error("Not a simulation snapshot");
+  }
+  std::uint32_t version = read<std::uint32_t>();
+  if (version != SnapshotWriter::version) {
+    throw std::runtime_error("Unsupported snapshot version " +
+                             std::to_string(version));
+  }
+}
+
+std::string SnapshotReader::readString() {
+  std::uint64_t size = read<std::uint64_t>();
+  std::string value(size, '\0');
+  in.read(value.data(), size);
+  check();
+  return value;
+}
+
+void SnapshotReader::check() const {
+  if (!in) throw std::runtime_error("Snapshot ends early");
+}
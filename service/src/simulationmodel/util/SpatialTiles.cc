@@ -0,0 +1,102 @@
+#include "SpatialTiles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+SpatialTiles::SpatialTiles(double size) : edge(size) {}
+
+void SpatialTiles::setSize(double size) {
+  edge = size;
+  ids.clear();
+  keys.clear();
+}
+
+double SpatialTiles::getSize() const { return edge; }
+
+bool SpatialTiles::isEnabled() const { return edge > 0; }
+
+std::int64_t SpatialTiles::key(const Vector3& position) const {
+  if (!isEnabled()) return 0;
+  // tiles cover the ground, so altitude does not matter
+  auto column = static_cast<std::int32_t>(std::floor(position.x / edge));
+  auto row = static_cast<std::int32_t>(std::floor(position.z / edge));
+  return (static_cast<std::int64_t>(column) << 32) |
+         static_cast<std::uint32_t>(row);
+}
+
+bool SpatialTiles::assign(const std::vector<int>& ids,
+                          const EntityStore& store) {
+  std::vector<std::int64_t> next(ids.size());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    next[i] = key(store.positions[store.row(ids[i])]);
+  }
+
+  // both lists are in id order, so one merge finds who joined, left or moved
+  bool changed = false;
+  size_t last = 0;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    while (last < this->ids.size() && this->ids[last] < ids[i]) {
+      changed = true;
+      ++last;
+    }
+    if (last < this->ids.size() && this->ids[last] == ids[i]) {
+      if (keys[last] != next[i]) {
+        changed = true;
+        ++migrations;
+      }
+      ++last;
+    } else {
+      changed = true;
+    }
+  }
+  if (last < this->ids.size()) changed = true;
+  // the same entities in the same tiles keep the tiles of the last call
+  if (!changed) return false;
+  this->ids = ids;
+  keys.swap(next);
+
+  // group the entities by tile, keeping id order within a tile
+  std::vector<size_t> sorted(ids.size());
+  std::iota(sorted.begin(), sorted.end(), 0);
+  std::stable_sort(sorted.begin(), sorted.end(), [this](size_t a, size_t b) {
+    return keys[a] < keys[b];
+  });
+  std::vector<std::pair<size_t, size_t>> tiles;
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    if (i == 0 || keys[sorted[i]] != keys[sorted[i - 1]]) {
+      tiles.push_back({i, i});
+    }
+    tiles.back().second = i + 1;
+  }
+
+  // largest tiles first, so the small ones fill in at the end of the update
+  std::stable_sort(tiles.begin(), tiles.end(),
+                   [](const auto& a, const auto& b) {
+                     return a.second - a.first > b.second - b.first;
+                   });
+  members.clear();
+  starts.clear();
+  for (const auto& [first, past] : tiles) {
+    starts.push_back(members.size());
+    members.insert(members.end(), sorted.begin() + first,
+                   sorted.begin() + past);
+  }
+  starts.push_back(members.size());
+  return changed;
+}
+
+size_t SpatialTiles::size() const {
+  return starts.empty() ? 0 : starts.size() - 1;
+}
+
+const size_t* SpatialTiles::begin(size_t tile) const {
+  return members.data() + starts[tile];
+}
+
+const size_t* SpatialTiles::end(size_t tile) const {
+  return members.data() + starts[tile + 1];
+}
+
+unsigned long SpatialTiles::getMigrations() const { return migrations; }
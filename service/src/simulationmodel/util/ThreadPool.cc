@@ -0,0 +1,74 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads) {
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t i = 1; i < threads; ++i) {
+    workers.emplace_back(&ThreadPool::run, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  loopStarted.notify_all();
+  for (std::thread& worker : workers) worker.join();
+}
+
+size_t ThreadPool::size() const { return workers.size() + 1; }
+
+void ThreadPool::parallelFor(size_t count,
+                             const std::function<void(size_t)>& task,
+                             size_t grain) {
+  grain = std::max<size_t>(grain, 1);
+  if (workers.empty() || count <= grain) {
+    for (size_t i = 0; i < count; ++i) task(i);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->task = &task;
+    this->count = count;
+    this->grain = grain;
+    next = 0;
+    busy = workers.size();
+    ++generation;
+  }
+  loopStarted.notify_all();
+  work();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  loopFinished.wait(lock, [this] { return busy == 0; });
+  this->task = nullptr;
+}
+
+void ThreadPool::run() {
+  unsigned long seen = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    loopStarted.wait(lock,
+                     [this, seen] { return stopping || generation != seen; });
+    if (stopping) return;
+    seen = generation;
+
+    lock.unlock();
+    work();
+    lock.lock();
+    if (--busy == 0) loopFinished.notify_one();
+  }
+}
+
+void ThreadPool::work() {
+  while (true) {
+    size_t begin = next.fetch_add(grain);
+    if (begin >= count) return;
+    size_t end = std::min(begin + grain, count);
+    for (size_t i = begin; i < end; ++i) (*task)(i);
+  }
+}
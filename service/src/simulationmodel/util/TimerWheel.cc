@@ -0,0 +1,80 @@
+#include "TimerWheel.h"
+
+#include <algorithm>
+#include <cmath>
+
+TimerWheel::TimerWheel(double resolution) : resolution(resolution) {}
+
+TimerWheel::Handle TimerWheel::schedule(double time,
+                                        std::function<void()> callback) {
+  Handle handle = nextHandle++;
+  long due = static_cast<long>(std::ceil(time / resolution - 1e-9));
+  // the current tick already ran
+  insert({handle, std::max(due, now + 1), std::move(callback)});
+  pending.insert(handle);
+  ++stored;
+  return handle;
+}
+
+void TimerWheel::cancel(Handle handle) { pending.erase(handle); }
+
+void TimerWheel::advance(double time) {
+  long target = static_cast<long>(std::floor(time / resolution + 1e-9));
+  while (now < target) {
+    if (pending.empty()) {
+      // nothing left to fire, so the wheel can jump straight to the target
+      if (stored) {
+        for (auto& level : wheel) {
+          for (auto& slot : level) slot.clear();
+        }
+        overflow.clear();
+        stored = 0;
+      }
+      now = target;
+      return;
+    }
+    step();
+  }
+}
+
+size_t TimerWheel::size() const { return pending.size(); }
+
+void TimerWheel::insert(Timer timer) {
+  long delta = timer.due - now;
+  for (int level = 0; level < levels; ++level) {
+    if (delta < 1L << (slotBits * (level + 1))) {
+      long slot = (timer.due >> (slotBits * level)) & (slots - 1);
+      wheel[level][slot].push_back(std::move(timer));
+      return;
+    }
+  }
+  overflow.push_back(std::move(timer));
+}
+
+void TimerWheel::step() {
+  ++now;
+
+  // whenever a level wraps, the next slot of the level above moves down
+  for (int level = 1; level <= levels; ++level) {
+    if (now & ((1L << (slotBits * level)) - 1)) break;
+    std::vector<Timer> timers;
+    if (level == levels) {
+      timers.swap(overflow);
+    } else {
+      timers.swap(wheel[level][(now >> (slotBits * level)) & (slots - 1)]);
+    }
+    for (Timer& timer : timers) insert(std::move(timer));
+  }
+
+  std::vector<Timer> due;
+  due.swap(wheel[0][now & (slots - 1)]);
+  std::sort(due.begin(), due.end(), [](const Timer& a, const Timer& b) {
+    return a.handle < b.handle;
+  });
+  stored -= due.size();
+  for (Timer& timer : due) {
+    // cancelled timers are only dropped here
+    if (!pending.erase(timer.handle)) continue;
+    timer.callback();
+  }
+}
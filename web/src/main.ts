@@ -213,39 +213,46 @@ window.onresize = () => {
 
 initScheduler();
 
+function onAddEntity(details: any) {
+  addEntity(details.id, details.details);
+
+  // Track packages for priority management
+  if (details.details && details.details.type === "package") {
+    const entityName = details.details.name;
+    const entityId = details.id;
+    const position = new THREE.Vector3(...details.pos);
+
+    // Get priority if available
+    let priority = "Standard";
+    if (details.priority) {
+      priority = details.priority;
+    }
+
+    // Add to package tracking
+    packages.set(entityId, {
+      id: entityId,
+      name: entityName,
+      priority: priority,
+      position: position,
+      isPickedUp: false
+    });
+
+    // Refresh UI if the priority management panel is open
+    if (!changePriorityInput.hidden) {
+      refreshPackagesLocally();
+    }
+  }
+}
+
 connect().then((socket) => {
   socket.onmessage = (msg) => {
     const data = JSON.parse(msg.data);
     switch (data.event) {
       case "AddEntity":
-        addEntity(data.details.id, data.details.details);
-        
-        // Track packages for priority management
-        if (data.details.details && data.details.details.type === "package") {
-          const entityName = data.details.details.name;
-          const entityId = data.details.id;
-          const position = new THREE.Vector3(...data.details.pos);
-          
-          // Get priority if available
-          let priority = "Standard";
-          if (data.details.priority) {
-            priority = data.details.priority;
-          }
-          
-          // Add to package tracking
-          packages.set(entityId, {
-            id: entityId,
-            name: entityName,
-            priority: priority,
-            position: position,
-            isPickedUp: false
-          });
-          
-          // Refresh UI if the priority management panel is open
-          if (!changePriorityInput.hidden) {
-            refreshPackagesLocally();
-          }
-        }
+        onAddEntity(data.details);
+        break;
+      case "AddEntities":
+        data.details.entities.forEach(onAddEntity);
         break;
       case "UpdateEntity":
         updateEntity(data.details.id, data.details);
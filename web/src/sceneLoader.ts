@@ -5,7 +5,20 @@ import { sendCommand } from "./websocket_api";
 
 function loadScene(file: string) {
   $.getJSON(file, (data) => {
+    // consecutive entities are created with one command and one reply
+    let batch: any[] = [];
+    const flush = () => {
+      if (batch.length > 0) {
+        sendCommand("CreateEntities", { entities: batch });
+        batch = [];
+      }
+    };
     data.forEach((command: any) => {
+      if (command.command == "CreateEntity") {
+        batch.push(command.params);
+        return;
+      }
+      flush();
       switch (command.command) {
         case "SetScene":
           loadModel(command.params);
@@ -22,6 +35,7 @@ function loadScene(file: string) {
           break;
       }
     });
+    flush();
   });
 }
 